@@ -12,7 +12,24 @@
 #include "JL_ActionTree_Action.h"
 #include "JL_ActionTree_ActionDynamic.h"
 #include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Firewall.h"
+#include "JL_ActionTree_HotSwap.h"
+#include "JL_ActionTree_Blackboard.h"
+#include "JL_ActionTree_Memo.h"
+#include "JL_ActionTree_Adaptive.h"
 #include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Switch.h"
+#include "JL_ActionTree_Fold.h"
+#include "JL_ActionTree_Hint.h"
+#include "JL_ActionTree_Parallel.h"
+#include "JL_ActionTree_Pipeline.h"
+#include "JL_ActionTree_Batch.h"
+#include "JL_ActionTree_Shared.h"
+#include "JL_ActionTree_Tick.h"
+#include "JL_ActionTree_TruthTable.h"
+#include "JL_ActionTree_Reactive.h"
+#include "JL_ActionTree_Script.h"
+#include "JL_ActionTree_Async.h"
 
 #undef TEMPLATE
 #undef TEMPLATE2
@@ -17,8 +17,10 @@ namespace JL::action_tree
 	template <typename F>
 	struct Action : impl::Functor<F>
 	{
-		TEMPLATE  /* Action */ operator |  (Action <T   >);
-		TEMPLATEV /* Action */ operator |  (Visitor<T...>);
+		TEMPLATE  /* Action */ operator |  (Action <T   >) const&;
+		TEMPLATE  /* Action */ operator |  (Action <T   >) &&;
+		TEMPLATEV /* Action */ operator |  (Visitor<T...>) const&;
+		TEMPLATEV /* Action */ operator |  (Visitor<T...>) &&;
 	};
 
 	template <typename T>
@@ -26,6 +28,95 @@ namespace JL::action_tree
 
 }
 
+namespace JL::action_tree::impl
+{
+
+	// Flattened `a | b | c | ...`
+	template <typename ... A>
+	struct Sequence
+	{
+		std::tuple<A...> actions;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	template <typename T>
+	constexpr bool is_sequence_v = false;
+
+	// Result of a sequence with stages that return an expected: an expected of the values of all stages, with the
+	// error of the first one that failed. void when no stage can fail.
+	template <typename ... R>
+	struct SequenceExpected;
+
+	template <typename ... R>
+	using SequenceExpected_t = typename SequenceExpected<R...>::type;
+
+	template <typename ... A>
+	constexpr bool is_sequence_v<Sequence<A...>> = true;
+
+	// a | visitor
+	template <typename A, typename V>
+	struct Visit
+	{
+		A action;
+		V visitor;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	template <typename F, typename ... P>
+	struct Stateless<Action<F>, P...> : Stateless<F, P...> {};
+
+	template <typename ... A, typename ... P>
+	struct Stateless<Sequence<A...>, P...> : std::conjunction<Stateless<A, P...>...> {};
+
+	// Only asked once the action is known to be stateless
+	template <typename A, typename V, typename ... P>
+	struct StatelessVisitor : std::is_invocable<V const&, std::invoke_result_t<A const&, P...>> {};
+
+	template <typename A, typename V, typename ... P>
+	struct Stateless<Visit<A, V>, P...> : std::conjunction<Stateless<A, P...>, StatelessVisitor<A, V, P...>> {};
+
+	// Result of a stage that has run, but is not gathered yet
+	template <typename R>
+	struct Slot
+	{
+		Maybe<R> value;
+
+		template <typename F>
+		constexpr void Fill(F&& f) { value.emplace(f()); }
+		template <typename V>
+		constexpr void Put(V&& v)  { value.emplace(std::forward<V>(v)); }
+		constexpr R    Take()      { return std::move(*value); }
+	};
+
+	template <>
+	struct Slot<void>
+	{
+		template <typename F>
+		constexpr void Fill(F&& f) { f(); }
+		constexpr void Put()       {}
+		constexpr void Take()      {}
+	};
+
+	// Stage of Gather that takes the results out of a tuple of slots
+	template <typename S>
+	struct SlotStage
+	{
+		S& slots;
+
+		template <typename I>
+		constexpr decltype(auto) operator () (I) { return std::get<I::value>(slots).Take(); }
+	};
+
+}
+
 
 
 // Implementation
@@ -45,49 +136,264 @@ namespace JL::action_tree
 		template <typename A, typename B>
 		constexpr bool is_addable_v = is_addable<A, B>::value;
 
-	}
+		//---------------
+		//   Sequence
 
-	template <typename _T>
-	template <typename T>
-	auto Action<_T>::operator|(Action<T> other)
-	{
-		auto f {
-			[a = *this, b = std::move(other)]
-			(auto&& ... p) mutable
+		// Stage I gives the value of an expected that has one, the other stages run as they are
+		template <size_t I, typename S, typename X>
+		struct ValueStage
+		{
+			S& stage;
+			X& expected;
+
+			template <typename J>
+			constexpr decltype(auto) operator () (J)
+			{
+				if constexpr (J::value != I)
+					return stage(J{});
+				else
+				if constexpr (!std::is_void_v<typename X::value_type>)
+					return *std::move(expected);
+			}
+		};
+
+		// Puts the results of the stages of a sequence together, stage(index) runs stage I and returns its result.
+		// Every result is kept in a local of its own frame, so results are only moved once: into the final tuple.
+		// With an expected X, a stage that returns an expected adds its value, or ends the sequence with its error.
+		template <size_t I, size_t N, typename X = void, typename S, typename ... R>
+		constexpr auto Gather(S& stage, std::tuple<R&...> results)
+		{
+			if constexpr (I == N && !std::is_void_v<X>)
 			{
-				using A = decltype(a(p...));
-				using B = decltype(b(p...));
+				if constexpr (sizeof...(R) == 0)
+					return X{};
+				else
+					return X(Gather<I, N>(stage, results));
+			}
+			else
+			if constexpr (I == N)
+			{
+				if constexpr (sizeof...(R) == 0)			// void
+					return;
+				else
+				if constexpr (sizeof...(R) == 1)			// A
+					return std::move(std::get<0>(results));
+				else										// {A, B, ...}
+					return std::apply(
+						[](R& ... r) { return std::tuple<R...>{ std::move(r)... }; },
+						results
+					);
+			}
+			else
+			{
+				using Index = std::integral_constant<size_t, I>;
+				using B     = decltype(stage(Index{}));
 
-				if constexpr (std::is_void_v<A>)			// A = void
-					return a(p...), b(p...);
+				if constexpr (!std::is_void_v<X> && is_expected_v<B>)
+				{
+					auto out = stage(Index{});
+					if (!out.has_value())
+						return X{ typename X::unexpected_type{ std::move(out).error() } };
+					ValueStage<I, S, decltype(out)> value{ stage, out };
+					return Gather<I, N, X>(value, results);
+				}
 				else
 				if constexpr (std::is_void_v<B>)			// B = void
 				{
-					auto out = a(p...);
-					return b(p...), out;
+					stage(Index{});
+					return Gather<I + 1, N, X>(stage, results);
+				}
+				else
+				if constexpr (sizeof...(R) == 0)			// first value
+				{
+					auto out = stage(Index{});
+					return Gather<I + 1, N, X>(stage, std::tie(out));
 				}
 				else
-				if constexpr (impl::is_addable_v<A, B>)		// A + B
-					return a(p...) + b(p...);
-				else										// {A, B}
-					return std::pair{ a(p...), b(p...) };
+				if constexpr (sizeof...(R) == 1)
+				{
+					using Ra = std::tuple_element_t<0, std::tuple<R...>>;
+					if constexpr (is_addable_v<Ra, B>)		// A + B
+					{
+						auto out = std::move(std::get<0>(results)) + stage(Index{});
+						return Gather<I + 1, N, X>(stage, std::tie(out));
+					}
+					else									// {A, B}
+					{
+						auto out = stage(Index{});
+						return Gather<I + 1, N, X>(stage, std::tuple_cat(results, std::tie(out)));
+					}
+				}
+				else										// {A, B, ...}
+				{
+					auto out = stage(Index{});
+					return Gather<I + 1, N, X>(stage, std::tuple_cat(results, std::tie(out)));
+				}
 			}
+		}
+
+		template <typename R>
+		using bare_t = std::remove_cv_t<std::remove_reference_t<R>>;
+
+		template <typename R, bool = is_expected_v<R>>
+		struct ExpectedValue { using type = R; };
+
+		template <typename R>
+		struct ExpectedValue<R, true> { using type = typename bare_t<R>::value_type; };
+
+		template <typename R, bool = is_expected_v<R>>
+		struct ExpectedError { using type = void; };
+
+		template <typename R>
+		struct ExpectedError<R, true> { using type = typename bare_t<R>::error_type; };
+
+		// Stages that give the values of their results, only for the type of what they gather to
+		template <typename ... R>
+		struct ValueTypes
+		{
+			template <typename J>
+			auto operator () (J) -> typename ExpectedValue<std::tuple_element_t<J::value, std::tuple<R...>>>::type;
+		};
+
+		template <typename ... R>
+		struct FirstExpected;
+
+		template <typename R, typename ... Rs>
+		struct FirstExpected<R, Rs...>
+		{
+			struct Found { using type = bare_t<R>; };
+			using type = typename std::conditional_t<is_expected_v<R>, Found, FirstExpected<Rs...>>::type;
+		};
+
+		template <typename X, typename T>
+		struct RebindExpected;
+
+		template <template <typename, typename> typename X, typename V, typename E, typename T>
+		struct RebindExpected<X<V, E>, T> { using type = X<T, E>; };
+
+		template <bool Fails, typename ... R>
+		struct SequenceExpectedOf { using type = void; };
+
+		template <typename ... R>
+		struct SequenceExpectedOf<true, R...>
+		{
+			using First  = typename FirstExpected<R...>::type;
+			using Values = decltype(Gather<0, sizeof...(R)>(std::declval<ValueTypes<R...>&>(), std::tuple<>{}));
+			using type   = typename RebindExpected<First, Values>::type;
+
+			static_assert(((!is_expected_v<R> || std::is_same_v<typename ExpectedError<R>::type, typename First::error_type>) && ...),
+				"Sequence  Every stage that can fail needs the same error type.");
 		};
-		return Action<decltype(f)>{ std::move(f) };
+
+		template <typename ... R>
+		struct SequenceExpected : SequenceExpectedOf<(is_expected_v<R> || ...), R...> {};
+
+		//---------------
+		//   Sequence
+
+		template <typename ... A>
+		template <typename ... P>
+		constexpr auto Sequence<A...>::operator()(P&& ... p)
+		{
+			if constexpr (is_awaitable_v<decltype(std::declval<A&>()(p...))...>)
+				return RunAsync(*this, Capture(std::forward<P>(p)...));
+			else
+			{
+				auto stage = [&](auto index) -> decltype(auto)
+				{
+					constexpr size_t I = decltype(index)::value;
+					if constexpr (I + 1 == sizeof...(A))
+						return std::get<I>(actions)(std::forward<P>(p)...);
+					else
+						return std::get<I>(actions)(p...);
+				};
+				using X = SequenceExpected_t<decltype(std::declval<A&>()(p...))...>;
+				return Gather<0, sizeof...(A), X>(stage, std::tuple<>{});
+			}
+		}
+
+		template <typename ... A>
+		template <typename ... P>
+		constexpr auto Sequence<A...>::operator()(P&& ... p) const
+		{
+			RequireStateless<P...>(*this);
+			auto stage = [&](auto index) -> decltype(auto)
+			{
+				constexpr size_t I = decltype(index)::value;
+				if constexpr (I + 1 == sizeof...(A))
+					return std::get<I>(actions)(std::forward<P>(p)...);
+				else
+					return std::get<I>(actions)(p...);
+			};
+			using X = SequenceExpected_t<decltype(std::declval<A const&>()(p...))...>;
+			return Gather<0, sizeof...(A), X>(stage, std::tuple<>{});
+		}
+
+		//------------
+		//   Visit
+
+		template <typename A, typename V>
+		template <typename ... P>
+		constexpr auto Visit<A, V>::operator()(P&& ... p)
+		{
+			if constexpr (is_awaitable_v<decltype(action(p...))>)
+				return RunAsync(*this, Capture(std::forward<P>(p)...));
+			else
+				return visitor(action(std::forward<P>(p)...));
+		}
+
+		template <typename A, typename V>
+		template <typename ... P>
+		constexpr auto Visit<A, V>::operator()(P&& ... p) const
+		{
+			RequireStateless<P...>(*this);
+			return visitor(action(std::forward<P>(p)...));
+		}
+
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Action<_T>::operator|(Action<T> other) const&
+	{
+		return Action<_T>(*this) | std::move(other);
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Action<_T>::operator|(Action<T> other) &&
+	{
+		if constexpr (impl::is_sequence_v<_T>)
+		{
+			return std::apply(
+				[&other](auto&& ... actions)
+				{
+					using Sequence = impl::Sequence<std::decay_t<decltype(actions)>..., Action<T>>;
+					return Action<Sequence>{ Sequence{ { std::move(actions)..., std::move(other) } } };
+				},
+				std::move(this->actions)
+			);
+		}
+		else
+		{
+			using Sequence = impl::Sequence<Action<_T>, Action<T>>;
+			return Action<Sequence>{ Sequence{ { std::move(*this), std::move(other) } } };
+		}
 	}
 
 	template <typename _T>
 	template <typename ...T>
-	auto Action<_T>::operator|(Visitor<T...> visitor)
+	constexpr auto Action<_T>::operator|(Visitor<T...> visitor) const&
 	{
-		auto f{
-			[a = *this, v = std::move(visitor)]
-			(auto&& ... p) mutable
-			{
-				return v(a(p...));
-			}
-		};
-		return Action<decltype(f)>{ std::move(f) };
+		return Action<_T>(*this) | std::move(visitor);
+	}
+
+	template <typename _T>
+	template <typename ...T>
+	constexpr auto Action<_T>::operator|(Visitor<T...> visitor) &&
+	{
+		using Visit = impl::Visit<Action<_T>, Visitor<T...>>;
+		return Action<Visit>{ Visit{ std::move(*this), std::move(visitor) } };
 	}
 
 }
\ No newline at end of file
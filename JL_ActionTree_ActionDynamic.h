@@ -11,6 +11,59 @@
 #include "JL_ActionTree_Base.h"
 #include "JL_ActionTree_Action.h"
 
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace JL::action_tree::impl
+{
+
+	template <typename>
+	struct InplaceVtable {};
+
+	template <typename R, typename ... P>
+	struct InplaceVtable<R(P...)>
+	{
+		R    (*call)   (void*, P&& ...);
+		void (*copy)   (void*, void const*); // null when the action cannot be copied
+		void (*move)   (void*, void*);
+		void (*destroy)(void*);
+	};
+
+	template <typename, size_t Bytes>
+	struct InplaceCall {};
+
+	template <typename R, typename ... P, size_t Bytes>
+	struct InplaceCall<R(P...), Bytes>
+	{
+		InplaceCall () = default;
+		InplaceCall (InplaceCall const&);
+		InplaceCall (InplaceCall&&) noexcept;
+		~InplaceCall();
+
+		InplaceCall& operator = (InplaceCall const&);
+		InplaceCall& operator = (InplaceCall&&) noexcept;
+
+		R operator() (P ...) const;
+
+		explicit operator bool () const noexcept;
+
+	protected:
+
+		template <bool Copyable, typename T>
+		void Assign(Action<T>&&);
+
+		void Reset() noexcept;
+
+	private:
+
+		alignas(std::max_align_t) mutable std::byte storage[Bytes];
+		InplaceVtable<R(P...)> const* vtable{};
+	};
+
+}
+
 namespace JL::action_tree
 {
 
@@ -23,11 +76,60 @@ namespace JL::action_tree
 		explicit             ActionDynamic () = default;
 		template<typename T>
 		explicit             ActionDynamic (Action<T>);
-		TEMPLATE /* This& */ operator =    (Action<T>);
+		template<typename T>
+		auto     /* This& */ operator =    (Action<T>);
+	};
+
+	// Same as ActionDynamic, but stores the action in place instead of on the heap.
+	// An action larger than Bytes is rejected at compile time.
+	template <typename, size_t Bytes = 64>
+	struct ActionDynamicInplace {};
+
+	template <typename R, typename ... P, size_t Bytes>
+	struct ActionDynamicInplace<R(P...), Bytes> : impl::InplaceCall<R(P...), Bytes>
+	{
+		explicit              ActionDynamicInplace () = default;
+		template<typename T>
+		explicit              ActionDynamicInplace (Action<T>);
+		template<typename T>
+		ActionDynamicInplace& operator =           (Action<T>);
 	};
 
+	// Move-only ActionDynamicInplace, accepts actions that cannot be copied.
+	template <typename, size_t Bytes = 64>
+	struct ActionDynamicMoveOnly {};
 
-};
+	template <typename R, typename ... P, size_t Bytes>
+	struct ActionDynamicMoveOnly<R(P...), Bytes> : impl::InplaceCall<R(P...), Bytes>
+	{
+		explicit               ActionDynamicMoveOnly () = default;
+		                       ActionDynamicMoveOnly (ActionDynamicMoveOnly&&) = default;
+		ActionDynamicMoveOnly& operator =            (ActionDynamicMoveOnly&&) = default;
+		template<typename T>
+		explicit               ActionDynamicMoveOnly (Action<T>);
+		template<typename T>
+		ActionDynamicMoveOnly& operator =            (Action<T>);
+	};
+
+	namespace impl
+	{
+
+		// The action inside is not part of the type, it may keep state
+		template <typename S, typename ... P>
+		struct Stateless<std::function<S>, P...> : std::false_type {};
+
+		template <typename S, typename ... P>
+		struct Stateless<ActionDynamic<S>, P...> : std::false_type {};
+
+		template <typename S, size_t Bytes, typename ... P>
+		struct Stateless<ActionDynamicInplace<S, Bytes>, P...> : std::false_type {};
+
+		template <typename S, size_t Bytes, typename ... P>
+		struct Stateless<ActionDynamicMoveOnly<S, Bytes>, P...> : std::false_type {};
+
+	}
+
+}
 
 namespace JL::action_tree
 {
@@ -49,11 +151,181 @@ namespace JL::action_tree
 				[a = std::move(a)]
 				(P ... p) mutable->R
 				{
-					return a(p...);
+					return a(std::forward<P>(p)...);
 				}
 			);
 		}
-		else static_assert(false, "ActionDynamic::operator=(Action)  Action does not return the correct type.");
+		else static_assert(impl::dependent_false_v<T>, "ActionDynamic::operator=(Action)  Action does not return the correct type.");
+	}
+
+}
+
+
+
+namespace JL::action_tree::impl
+{
+
+	//------------------
+	//   InplaceCall
+
+	template <typename T, typename R, typename ... P>
+	constexpr InplaceVtable<R(P...)> inplace_vtable_v{
+		[](void* self, P&& ... p) -> R
+		{
+			return (*static_cast<T*>(self))(std::forward<P>(p)...);
+		},
+		[]
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+				return [](void* self, void const* other) { ::new (self) T(*static_cast<T const*>(other)); };
+			else
+				return static_cast<void(*)(void*, void const*)>(nullptr);
+		}(),
+		[](void* self, void* other)
+		{
+			::new (self) T(std::move(*static_cast<T*>(other)));
+		},
+		[](void* self)
+		{
+			static_cast<T*>(self)->~T();
+		}
+	};
+
+	template <typename R, typename ... P, size_t Bytes>
+	InplaceCall<R(P...), Bytes>::InplaceCall(InplaceCall const& other)
+	{
+		operator=(other);
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	InplaceCall<R(P...), Bytes>::InplaceCall(InplaceCall&& other) noexcept
+	{
+		operator=(std::move(other));
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	InplaceCall<R(P...), Bytes>::~InplaceCall()
+	{
+		Reset();
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	auto InplaceCall<R(P...), Bytes>::operator=(InplaceCall const& other) -> InplaceCall&
+	{
+		if (this != &other)
+		{
+			Reset();
+			// Left empty when the action cannot be copied
+			assert((!other.vtable || other.vtable->copy) && "InplaceCall  Copy of an action that cannot be copied.");
+			if (other.vtable && other.vtable->copy)
+			{
+				other.vtable->copy(storage, other.storage);
+				vtable = other.vtable;
+			}
+		}
+		return *this;
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	auto InplaceCall<R(P...), Bytes>::operator=(InplaceCall&& other) noexcept -> InplaceCall&
+	{
+		if (this != &other)
+		{
+			Reset();
+			if (other.vtable)
+			{
+				other.vtable->move(storage, other.storage);
+				vtable = other.vtable;
+				other.Reset();
+			}
+		}
+		return *this;
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	R InplaceCall<R(P...), Bytes>::operator()(P ... p) const
+	{
+		if (!vtable)
+			throw std::bad_function_call{};
+		return vtable->call(storage, std::forward<P>(p)...);
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	InplaceCall<R(P...), Bytes>::operator bool() const noexcept
+	{
+		return vtable != nullptr;
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	template <bool Copyable, typename T>
+	void InplaceCall<R(P...), Bytes>::Assign(Action<T>&& action)
+	{
+		using A = Action<T>;
+		if constexpr (Copyable)
+		{
+			static_assert(std::is_same_v<R, decltype(action(std::declval<P>()...))>, "ActionDynamicInplace::operator=(Action)  Action does not return the correct type.");
+			static_assert(sizeof(A) <= Bytes, "ActionDynamicInplace::operator=(Action)  Action does not fit, increase Bytes.");
+			static_assert(alignof(A) <= alignof(std::max_align_t), "ActionDynamicInplace::operator=(Action)  Action is over-aligned.");
+			static_assert(std::is_copy_constructible_v<A>, "ActionDynamicInplace::operator=(Action)  Action cannot be copied, use ActionDynamicMoveOnly.");
+		}
+		else
+		{
+			static_assert(std::is_same_v<R, decltype(action(std::declval<P>()...))>, "ActionDynamicMoveOnly::operator=(Action)  Action does not return the correct type.");
+			static_assert(sizeof(A) <= Bytes, "ActionDynamicMoveOnly::operator=(Action)  Action does not fit, increase Bytes.");
+			static_assert(alignof(A) <= alignof(std::max_align_t), "ActionDynamicMoveOnly::operator=(Action)  Action is over-aligned.");
+		}
+
+		Reset();
+		::new (static_cast<void*>(storage)) A(std::move(action));
+		vtable = &inplace_vtable_v<A, R, P...>;
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	void InplaceCall<R(P...), Bytes>::Reset() noexcept
+	{
+		if (vtable)
+			std::exchange(vtable, nullptr)->destroy(storage);
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	//---------------------------
+	//   ActionDynamicInplace
+
+	template <typename R, typename ... P, size_t Bytes>
+	template <typename T>
+	ActionDynamicInplace<R(P...), Bytes>::ActionDynamicInplace(Action<T> action)
+	{
+		operator=(std::move(action));
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	template <typename T>
+	auto ActionDynamicInplace<R(P...), Bytes>::operator=(Action<T> action) -> ActionDynamicInplace&
+	{
+		this->template Assign<true>(std::move(action));
+		return *this;
+	}
+
+	//----------------------------
+	//   ActionDynamicMoveOnly
+
+	template <typename R, typename ... P, size_t Bytes>
+	template <typename T>
+	ActionDynamicMoveOnly<R(P...), Bytes>::ActionDynamicMoveOnly(Action<T> action)
+	{
+		operator=(std::move(action));
+	}
+
+	template <typename R, typename ... P, size_t Bytes>
+	template <typename T>
+	auto ActionDynamicMoveOnly<R(P...), Bytes>::operator=(Action<T> action) -> ActionDynamicMoveOnly&
+	{
+		this->template Assign<false>(std::move(action));
+		return *this;
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Decision.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+namespace JL::action_tree
+{
+
+	// Lets every `a & b & ...` and `a | b | ...` group in the decision pick the order of its operands,
+	// from the cost and the outcomes it measures. The operands must be free of side effects.
+	// Groups are not thread safe, just like edges.
+	struct AdaptiveOptions
+	{
+		uint32_t period = 1024;		// calls between two reorders
+		uint32_t sample = 16;		// one in so many calls evaluates and times every operand, 0 never does and keeps the written order
+	};
+
+	template <typename T>
+	auto /*Decision*/ Adaptive(Decision<T>, AdaptiveOptions = {});
+
+	namespace impl
+	{
+
+		template <bool All, typename ... D>
+		struct AdaptiveGroup
+		{
+			static constexpr size_t N = sizeof...(D);
+
+			struct Stats
+			{
+				uint64_t cost;		// ticks, sampled calls only
+				uint32_t samples;
+				uint32_t hits;		// true outcomes
+			};
+
+			std::tuple<D...>          operands;
+			std::array<uint8_t, N>    order{};
+			std::array<Stats, N>      stats{};
+			AdaptiveOptions           options{};
+			uint32_t                  calls{};
+			bool                      enabled{ true };
+
+			AdaptiveGroup(std::tuple<D...>, AdaptiveOptions);
+
+			template <typename ... P>
+			bool operator () (P&& ...);
+
+			// Off: operands run in the order they were written in, and nothing is measured
+			void Enable(bool);
+
+			std::array<uint8_t, N> const& Order() const noexcept { return order; }
+
+		private:
+
+			template <size_t ... I, typename ... P>
+			bool Run(std::index_sequence<I...>, P& ...);
+
+			void Reorder();
+		};
+
+		// Cycle counter where there is one, a steady clock otherwise
+		uint64_t Ticks() noexcept;
+
+		template <typename T> constexpr bool is_and_v = false;
+		template <typename T> constexpr bool is_or_v  = false;
+		template <typename T> constexpr bool is_not_v = false;
+
+		template <typename A, typename B> constexpr bool is_and_v<And<A, B>> = true;
+		template <typename A, typename B> constexpr bool is_or_v <Or <A, B>> = true;
+		template <typename D>             constexpr bool is_not_v<Not<D>>    = true;
+
+		template <bool All, typename Operands>
+		struct GroupOf;
+
+		template <bool All, typename ... D>
+		struct GroupOf<All, std::tuple<D...>> { using type = AdaptiveGroup<All, D...>; };
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	inline uint64_t Ticks() noexcept
+	{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+		return __rdtsc();
+#else
+		return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	template <bool All, typename ... D>
+	AdaptiveGroup<All, D...>::AdaptiveGroup(std::tuple<D...> operands, AdaptiveOptions options)
+		: operands{ std::move(operands) }
+		, options{ options }
+	{
+		std::iota(order.begin(), order.end(), uint8_t{});
+	}
+
+	template <bool All, typename ... D>
+	void AdaptiveGroup<All, D...>::Enable(bool on)
+	{
+		enabled = on;
+		calls   = 0;
+		stats   = {};
+		std::iota(order.begin(), order.end(), uint8_t{});
+	}
+
+	template <bool All, typename ... D>
+	template <typename ... P>
+	bool AdaptiveGroup<All, D...>::operator()(P&& ... p)
+	{
+		static_assert(!is_awaitable_v<decltype(std::declval<D&>()(p...))...>, "Awaitable decisions can not be reordered");
+		return Run(std::index_sequence_for<D...>{}, p...);
+	}
+
+	template <bool All, typename ... D>
+	template <size_t ... I, typename ... P>
+	bool AdaptiveGroup<All, D...>::Run(std::index_sequence<I...>, P& ... p)
+	{
+		using Test = bool(*)(std::tuple<D...>&, P&...);
+		static constexpr Test test[]{
+			+[](std::tuple<D...>& operands, P& ... q) -> bool { return std::get<I>(operands)(q...); }...
+		};
+
+		// All: stop at the first false, any: stop at the first true
+		if (!enabled || options.sample == 0 || ++calls % options.sample != 0)
+		{
+			for (uint8_t const i : order)
+				if (test[i](operands, p...) != All)
+					return !All;
+			return All;
+		}
+
+		// Sampled call, every operand runs so that the outcomes of the late ones are known too
+		bool out{ All };
+		for (uint8_t const i : order)
+		{
+			uint64_t const begin{ Ticks() };
+			bool const     hit  { test[i](operands, p...) };
+			stats[i].cost += Ticks() - begin;
+			stats[i].samples += 1;
+			stats[i].hits    += hit;
+			if (hit != All)
+				out = !All;
+		}
+
+		if (calls >= options.period)
+			Reorder();
+		return out;
+	}
+
+	template <bool All, typename ... D>
+	void AdaptiveGroup<All, D...>::Reorder()
+	{
+		// Expected cost is least when operands go by cost over the chance that they end the group
+		std::array<double, N> score{};
+		for (size_t i{}; i < N; ++i)
+		{
+			auto const& s = stats[i];
+			if (!s.samples)
+				return;
+			double const cost { double(s.cost) / s.samples };
+			double const ends { double(All ? s.samples - s.hits : s.hits) / s.samples };
+			score[i] = ends > 0 ? cost / ends : std::numeric_limits<double>::infinity();
+		}
+		std::stable_sort(order.begin(), order.end(), [&score](uint8_t a, uint8_t b) { return score[a] < score[b]; });
+
+		// Older measurements count for less, so that the order follows changes
+		for (auto& s : stats)
+		{
+			s.cost    /= 2;
+			s.samples /= 2;
+			s.hits    /= 2;
+		}
+		calls = 0;
+	}
+
+	//----------------
+	//   Flattening
+
+	template <bool All, typename T>
+	auto Operands(Decision<T>&&, AdaptiveOptions);
+
+	template <typename T>
+	auto Adapt(Decision<T>&& decision, AdaptiveOptions options)
+	{
+		if constexpr (is_and_v<T> || is_or_v<T>)
+		{
+			constexpr bool All = is_and_v<T>;
+			auto operands = std::tuple_cat(Operands<All>(std::move(decision.a), options), Operands<All>(std::move(decision.b), options));
+			using Group = typename GroupOf<All, decltype(operands)>::type;
+			return Decision<Group>{ Group{ std::move(operands), options } };
+		}
+		else
+		if constexpr (is_not_v<T>)
+			return !Adapt(std::move(decision.decision), options);
+		else
+			return std::move(decision);
+	}
+
+	// Operands of a group, nested groups of the same kind are flattened into it
+	template <bool All, typename T>
+	auto Operands(Decision<T>&& decision, AdaptiveOptions options)
+	{
+		if constexpr (All ? is_and_v<T> : is_or_v<T>)
+			return std::tuple_cat(Operands<All>(std::move(decision.a), options), Operands<All>(std::move(decision.b), options));
+		else
+			return std::tuple{ Adapt(std::move(decision), options) };
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename T>
+	auto Adaptive(Decision<T> decision, AdaptiveOptions options)
+	{
+		return impl::Adapt(std::move(decision), options);
+	}
+
+}
\ No newline at end of file
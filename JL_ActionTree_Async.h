@@ -0,0 +1,809 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Switch.h"
+
+#ifdef __cpp_impl_coroutine
+
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	// Thrown inside a cancelled task at its next suspension point, and out of its Get
+	struct Cancelled : std::exception
+	{
+		char const* what() const noexcept override { return "action tree task cancelled"; }
+	};
+
+	// Lazy coroutine task, nodes return one as soon as one of their children returns an awaitable.
+	// It does not run before it is started or awaited, and refers to its tree: the tree must outlive it.
+	template <typename T = void>
+	class Task
+	{
+	public:
+
+		struct promise_type;
+
+		Task() = default;
+		Task(Task&&) noexcept;
+		Task& operator = (Task&&) noexcept;
+		~Task();
+
+		// Driving it from plain code, Start runs it up to its first suspension and only once:
+		// a task that was started, awaited or spawned is resumed by whatever it waits on
+		void Start();
+		bool Done() const;
+		T    Get();
+		void Cancel();
+
+		// Awaiting it from a task, a cancel of the awaiting task also reaches this one
+		bool           await_ready() const noexcept;
+		template <typename P>
+		auto           await_suspend(std::coroutine_handle<P>) noexcept;
+		T              await_resume();
+
+	private:
+
+		std::coroutine_handle<promise_type> handle{};
+
+		explicit Task(std::coroutine_handle<promise_type>);
+
+		friend class EventLoop;
+	};
+
+	namespace impl
+	{
+
+		struct CancelledQuery {};
+
+	}
+
+	// Inside a task: `bool const stop = co_await isCancelled;`
+	inline constexpr impl::CancelledQuery isCancelled{};
+
+	// Single threaded scheduler, one loop drives any number of trees.
+	// Spawned tasks that are not done when it is destroyed are destroyed with it.
+	class EventLoop
+	{
+	public:
+
+		EventLoop() = default;
+		EventLoop(EventLoop const&) = delete;
+		EventLoop& operator = (EventLoop const&) = delete;
+		~EventLoop();
+
+		// Resumes the coroutine on a later turn
+		void   Post(std::coroutine_handle<>);
+
+		// Awaitable that lets every other ready coroutine run first
+		auto   Yield();
+
+		// Starts the task on the next turn, unless it was started already, and keeps it until it is done.
+		// Its result is dropped.
+		template <typename T>
+		void   Spawn(Task<T>);
+
+		// Resumes one coroutine, false when none was ready
+		bool   RunOnce();
+
+		// Runs until no coroutine is ready, rethrows the first error of a spawned task
+		size_t Run();
+
+		// Spawned tasks that are not done
+		size_t Pending() const;
+
+	private:
+
+		struct Root
+		{
+			std::coroutine_handle<> handle;
+			std::exception_ptr*     error;
+		};
+
+		std::deque<std::coroutine_handle<>> ready{};
+		std::vector<Root>                   roots{};
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	//------------------
+	//   Frame pool
+
+	// Frames of finished tasks are kept per thread and size, a tree that runs again does not allocate
+	class FramePool
+	{
+	public:
+
+		static FramePool& Local();
+
+		void*  Allocate(size_t);
+		void   Release (void*, size_t);
+
+		// Frames that came from the heap
+		size_t Fresh() const { return fresh; }
+
+		FramePool() = default;
+		FramePool(FramePool const&) = delete;
+		~FramePool();
+
+	private:
+
+		static constexpr size_t granule = 64;
+		static constexpr size_t classes = 32;
+
+		struct Free { Free* next; };
+
+		Free*  lists[classes]{};
+		size_t fresh{};
+	};
+
+	inline FramePool& FramePool::Local()
+	{
+		static thread_local FramePool pool{};
+		return pool;
+	}
+
+	inline void* FramePool::Allocate(size_t size)
+	{
+		size_t const c{ (size - 1) / granule };
+		if (c < classes && lists[c])
+			return std::exchange(lists[c], lists[c]->next);
+		++fresh;
+		return ::operator new(c < classes ? (c + 1) * granule : size);
+	}
+
+	inline void FramePool::Release(void* frame, size_t size)
+	{
+		size_t const c{ (size - 1) / granule };
+		if (c < classes)
+			lists[c] = new (frame) Free{ lists[c] };
+		else
+			::operator delete(frame);
+	}
+
+	inline FramePool::~FramePool()
+	{
+		for (Free* list : lists)
+			while (list)
+				::operator delete(std::exchange(list, list->next));
+	}
+
+	//---------------
+	//   Awaiters
+
+	template <typename T>
+	struct has_co_await : std::false_type {};
+
+	template <typename T>
+		requires requires (T&& t) { std::forward<T>(t).operator co_await(); }
+	struct has_co_await<T> : std::true_type {};
+
+	template <typename W>
+	decltype(auto) GetAwaiter(W&& w)
+	{
+		if constexpr (has_co_await<W>::value)
+			return std::forward<W>(w).operator co_await();
+		else
+			return std::forward<W>(w);
+	}
+
+	template <typename W>
+	using AwaitResult_t = decltype(GetAwaiter(std::declval<W>()).await_resume());
+
+	// Result of a child that did not need to wait
+	template <typename T>
+	struct Ready
+	{
+		T value;
+
+		bool await_ready() const noexcept { return true; }
+		void await_suspend(std::coroutine_handle<>) const noexcept {}
+		T    await_resume() { return std::move(value); }
+	};
+
+	template <>
+	struct Ready<void>
+	{
+		bool await_ready() const noexcept { return true; }
+		void await_suspend(std::coroutine_handle<>) const noexcept {}
+		void await_resume() const noexcept {}
+	};
+
+	// Runs a child with the kept arguments, gives an awaitable whatever it returns
+	template <typename F, typename Args>
+	auto Await(F& f, Args& args)
+	{
+		using R = decltype(std::apply(f, args));
+		if constexpr (is_awaitable_v<R>)
+			return std::apply(f, args);
+		else
+		if constexpr (std::is_void_v<R>)
+		{
+			std::apply(f, args);
+			return Ready<void>{};
+		}
+		else
+			return Ready<std::decay_t<R>>{ std::apply(f, args) };
+	}
+
+	// Awaits w, then hands its result to f
+	template <typename W, typename F>
+	struct ThenAwaiter
+	{
+		using Owned = std::decay_t<decltype(GetAwaiter(std::declval<W>()))>;
+
+		W            awaitable;
+		F            f;
+		Maybe<Owned> owned{};		// result of operator co_await, if W has one
+
+		Owned& awaiter()
+		{
+			if constexpr (has_co_await<W>::value)
+				return *owned;
+			else
+				return awaitable;
+		}
+
+		bool await_ready()
+		{
+			if constexpr (has_co_await<W>::value)
+				owned.emplace(GetAwaiter(std::move(awaitable)));
+			return awaiter().await_ready();
+		}
+
+		template <typename P>
+		auto await_suspend(std::coroutine_handle<P> h) { return awaiter().await_suspend(h); }
+
+		decltype(auto) await_resume()
+		{
+			if constexpr (std::is_void_v<decltype(awaiter().await_resume())>)
+			{
+				awaiter().await_resume();
+				return f();
+			}
+			else
+				return f(awaiter().await_resume());
+		}
+	};
+
+	template <typename W, typename F>
+	ThenAwaiter<W, F> Then(W&& w, F&& f)
+	{
+		return { std::move(w), std::forward<F>(f) };
+	}
+
+	// Puts an awaited result in the slot of a stack result
+	template <typename R>
+	struct WrapInto
+	{
+		template <typename ... V>
+		R operator () (V&& ... v) const
+		{
+			if constexpr (std::is_void_v<R>)
+				return;
+			else
+			if constexpr (sizeof...(V) == 0)
+				return EmptyResult<R>();
+			else
+				return WrapResult<R, std::decay_t<V>...>(std::forward<V>(v)...);
+		}
+	};
+
+	//--------------
+	//   Promise
+
+	struct PromiseBase;
+
+	// Makes every suspension point of a task a cancellation point
+	template <typename W>
+	struct Checked
+	{
+		W            awaiter;
+		PromiseBase* promise;
+
+		bool           await_ready();
+		template <typename P>
+		auto           await_suspend(std::coroutine_handle<P> h) { return awaiter.await_suspend(h); }
+		decltype(auto) await_resume();
+	};
+
+	// Marks the task as started on its first resume
+	struct InitialAwaiter
+	{
+		bool& started;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<>) const noexcept {}
+		void await_resume() const noexcept { started = true; }
+	};
+
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+		template <typename P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept { return h.promise().continuation; }
+		void await_resume() const noexcept {}
+	};
+
+	struct PromiseBase
+	{
+		std::coroutine_handle<>  continuation{ std::noop_coroutine() };
+		std::atomic<bool>        cancel{};
+		std::atomic<bool> const* root{ &cancel };
+		std::exception_ptr       error{};
+		bool                     started{};
+
+		bool Stopped() const noexcept
+		{
+			return cancel.load(std::memory_order_relaxed) || root->load(std::memory_order_relaxed);
+		}
+
+		InitialAwaiter      initial_suspend()       noexcept { return { started }; }
+		FinalAwaiter        final_suspend()   const noexcept { return {}; }
+		void                unhandled_exception() noexcept   { error = std::current_exception(); }
+
+		template <typename W>
+		auto await_transform(W&& w)
+		{
+			return Checked<decltype(GetAwaiter(std::forward<W>(w)))>{ GetAwaiter(std::forward<W>(w)), this };
+		}
+
+		Ready<bool> await_transform(CancelledQuery) const noexcept { return { Stopped() }; }
+
+		static void* operator new   (size_t size)              { return FramePool::Local().Allocate(size); }
+		static void  operator delete(void* frame, size_t size) { FramePool::Local().Release(frame, size); }
+	};
+
+	template <typename W>
+	bool Checked<W>::await_ready()
+	{
+		if (promise->Stopped())
+			throw Cancelled{};
+		return awaiter.await_ready();
+	}
+
+	template <typename W>
+	decltype(auto) Checked<W>::await_resume()
+	{
+		if (promise->Stopped())
+			throw Cancelled{};
+		return awaiter.await_resume();
+	}
+
+	template <typename T>
+	struct Result : PromiseBase
+	{
+		Maybe<T> value{};
+
+		template <typename V>
+		void return_value(V&& v) { value.emplace(std::forward<V>(v)); }
+
+		T Take()
+		{
+			if (error)
+				std::rethrow_exception(error);
+			return std::move(*value);
+		}
+	};
+
+	template <>
+	struct Result<void> : PromiseBase
+	{
+		void return_void() const noexcept {}
+
+		void Take()
+		{
+			if (error)
+				std::rethrow_exception(error);
+		}
+	};
+
+	//------------
+	//   Nodes
+	
+	// Every node keeps its arguments in its frame, and passes them to each child as lvalues.
+
+	// Stage I of a sequence with an expected X, false when it failed: its error is put in `failed`
+	template <size_t I, typename X, typename Slots, typename N, typename Args>
+	Task<bool> SequenceStep(N& node, Slots& slots, Args& args, Maybe<X>& failed)
+	{
+		auto& slot = std::get<I>(slots);
+		co_await Then(
+			Await(std::get<I>(node.actions), args),
+			[&slot](auto&& ... r) { slot.Put(std::forward<decltype(r)>(r)...); }
+		);
+
+		if constexpr (is_expected_v<decltype(slot.Take())>)
+			if (!slot.value->has_value())
+			{
+				failed.emplace(typename X::unexpected_type{ std::move(*slot.value).error() });
+				co_return false;
+			}
+		co_return true;
+	}
+
+	// Stops at the first error like the sequence that does not wait, its stages run one by one through a jump table
+	template <typename R, typename X, typename Slots, typename N, typename Args, size_t ... I>
+	Task<R> SequenceTask(N& node, Args args, std::index_sequence<I...>)
+	{
+		Slots            slots{};
+		SlotStage<Slots> stage{ slots };
+
+		if constexpr (std::is_void_v<X>)
+		{
+			(co_await Then(
+				Await(std::get<I>(node.actions), args),
+				[&slot = std::get<I>(slots)](auto&& ... r) { slot.Put(std::forward<decltype(r)>(r)...); }
+			), ...);
+			co_return Gather<0, sizeof...(I)>(stage, std::tuple<>{});
+		}
+		else
+		{
+			static constexpr Task<bool>(*step[])(N&, Slots&, Args&, Maybe<X>&){ &SequenceStep<I, X, Slots, N, Args>... };
+
+			Maybe<X> failed{};
+			for (size_t index{}; index < sizeof...(I); ++index)
+			{
+				bool const next = co_await step[index](node, slots, args, failed);
+				if (!next)
+					co_return std::move(*failed);
+			}
+			co_return Gather<0, sizeof...(I), X>(stage, std::tuple<>{});
+		}
+	}
+
+	template <typename ... A, typename Args>
+	auto RunAsync(Sequence<A...>& node, Args args)
+	{
+		using Slots = std::tuple<Slot<AwaitResult_t<decltype(Await(std::declval<A&>(), args))>>...>;
+		using X     = SequenceExpected_t<AwaitResult_t<decltype(Await(std::declval<A&>(), args))>...>;
+		using R     = decltype(Gather<0, sizeof...(A), X>(std::declval<SlotStage<Slots>&>(), std::tuple<>{}));
+		return SequenceTask<R, X, Slots>(node, std::move(args), std::index_sequence_for<A...>{});
+	}
+
+	template <typename R, typename N, typename Args>
+	Task<R> VisitTask(N& node, Args args)
+	{
+		co_return co_await Then(Await(node.action, args), node.visitor);
+	}
+
+	template <typename A, typename V, typename Args>
+	auto RunAsync(Visit<A, V>& node, Args args)
+	{
+		using Ra = AwaitResult_t<decltype(Await(node.action, args))>;
+		using R  = decltype(Then(Ready<Ra>{}, node.visitor).await_resume());
+		return VisitTask<R>(node, std::move(args));
+	}
+
+	template <typename D, typename Args>
+	Task<bool> RunAsync(Not<D>& node, Args args)
+	{
+		co_return !(co_await Await(node.decision, args));
+	}
+
+	template <typename A, typename B, typename Args>
+	Task<bool> RunAsync(Or<A, B>& node, Args args)
+	{
+		bool const a = co_await Await(node.a, args);
+		if (a)
+			co_return true;
+		co_return bool(co_await Await(node.b, args));
+	}
+
+	template <typename A, typename B, typename Args>
+	Task<bool> RunAsync(And<A, B>& node, Args args)
+	{
+		bool const a = co_await Await(node.a, args);
+		if (!a)
+			co_return false;
+		co_return bool(co_await Await(node.b, args));
+	}
+
+	template <typename D, typename A, bool Rising, typename Args>
+	Task<bool> RunAsync(Edge<D, A, Rising>& node, Args args)
+	{
+		bool const test = co_await Await(node.decision, args);
+		if (test != node.on && test == Rising)
+			(void)co_await Await(node.action, args);
+		co_return node.on = test;
+	}
+
+	template <typename R, typename N, typename Args>
+	Task<R> ConditionalTask(N& node, Args args)
+	{
+		bool const test = co_await Await(node.decision, args);
+		if constexpr (std::is_void_v<R>)
+		{
+			if (test)
+				co_await Await(node.action, args);
+		}
+		else
+		{
+			if (!test)
+				co_return R{};
+			co_return co_await Then(Await(node.action, args), WrapInto<R>{});
+		}
+	}
+
+	template <typename D, typename A, typename Args>
+	auto RunAsync(Conditional<D, A>& node, Args args)
+	{
+		using Ra = AwaitResult_t<decltype(Await(node.action, args))>;
+		using R  = std::conditional_t<std::is_void_v<Ra>, void, Maybe<Ra>>;
+		return ConditionalTask<R>(node, std::move(args));
+	}
+
+	// Stacks and switches test and run their branches through jump tables, like RunSwitch.
+	// The awaits stay plain statements, an await inside a condition is not reliably compiled by every compiler.
+
+	template <size_t I, typename N, typename Args>
+	Task<bool> CascadeTest(N& node, Args& args)
+	{
+		co_return bool(co_await Await(std::get<I>(node.branches).decision, args));
+	}
+
+	template <typename R, size_t I, typename N, typename Args>
+	Task<R> CascadeRun(N& node, Args& args)
+	{
+		if constexpr (I == std::tuple_size_v<decltype(node.branches)>)
+			co_return co_await Then(Await(node.fallback, args), WrapInto<R>{});
+		else
+			co_return co_await Then(Await(std::get<I>(node.branches).action, args), WrapInto<R>{});
+	}
+
+	template <typename R, typename N, typename Args, size_t ... I>
+	Task<R> CascadeTask(N& node, Args args, std::index_sequence<I...>)
+	{
+		static constexpr Task<bool>(*test[])(N&, Args&){ &CascadeTest<I, N, Args>... };
+		static constexpr Task<R>   (*run [])(N&, Args&){ &CascadeRun<R, I, N, Args>..., &CascadeRun<R, sizeof...(I), N, Args> };
+
+		size_t index{};
+		for (; index < sizeof...(I); ++index)
+		{
+			bool const hit = co_await test[index](node, args);
+			if (hit)
+				break;
+		}
+		co_return co_await run[index](node, args);
+	}
+
+	template <typename A, typename ... B, typename Args>
+	auto RunAsync(Cascade<A, B...>& node, Args args)
+	{
+		using R = StackResult_t<
+			AwaitResult_t<decltype(Await(std::declval<B&>().action, args))>...,
+			AwaitResult_t<decltype(Await(node.fallback, args))>
+		>;
+		return CascadeTask<R>(node, std::move(args), std::index_sequence_for<B...>{});
+	}
+
+	template <typename R, size_t I, typename N, typename Args>
+	Task<R> SwitchRun(N& node, Args& args)
+	{
+		if constexpr (I == std::tuple_size_v<decltype(node.cases)>)
+			co_return co_await Then(Await(node.fallback, args), WrapInto<R>{});
+		else
+			co_return co_await Then(Await(std::get<I>(node.cases).action, args), WrapInto<R>{});
+	}
+
+	template <typename R, typename Table, typename N, typename Args, size_t ... I>
+	Task<R> SwitchTask(N& node, Args args, std::index_sequence<I...>)
+	{
+		static constexpr Task<R>(*run[])(N&, Args&){ &SwitchRun<R, I, N, Args>... };
+
+		auto const key = co_await Await(node.key, args);
+		co_return co_await run[Table::Find(SwitchKey(key))](node, args);
+	}
+
+	template <typename K, typename A, typename ... C, typename Args>
+	auto RunAsync(SwitchDispatch<K, A, C...>& node, Args args)
+	{
+		using R = StackResult_t<
+			AwaitResult_t<decltype(Await(std::declval<C&>().action, args))>...,
+			AwaitResult_t<decltype(Await(node.fallback, args))>
+		>;
+		return SwitchTask<R, SwitchTable<C...>>(node, std::move(args), std::index_sequence_for<C..., A>{});
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	//-----------
+	//   Task
+
+	template <typename T>
+	struct Task<T>::promise_type : impl::Result<T>
+	{
+		Task get_return_object() noexcept
+		{
+			return Task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+		}
+	};
+
+	template <typename T>
+	Task<T>::Task(std::coroutine_handle<promise_type> handle)
+		: handle{ handle }
+	{}
+
+	template <typename T>
+	Task<T>::Task(Task&& other) noexcept
+		: handle{ std::exchange(other.handle, {}) }
+	{}
+
+	template <typename T>
+	Task<T>& Task<T>::operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (handle)
+				handle.destroy();
+			handle = std::exchange(other.handle, {});
+		}
+		return *this;
+	}
+
+	template <typename T>
+	Task<T>::~Task()
+	{
+		if (handle)
+			handle.destroy();
+	}
+
+	template <typename T>
+	void Task<T>::Start()
+	{
+		if (handle && !handle.promise().started)
+			handle.resume();
+	}
+
+	template <typename T>
+	bool Task<T>::Done() const
+	{
+		return !handle || handle.done();
+	}
+
+	template <typename T>
+	T Task<T>::Get()
+	{
+		if (!handle || !handle.done())
+			throw std::logic_error{ "task is not done" };
+		return handle.promise().Take();
+	}
+
+	template <typename T>
+	void Task<T>::Cancel()
+	{
+		if (handle)
+			handle.promise().cancel.store(true, std::memory_order_relaxed);
+	}
+
+	template <typename T>
+	bool Task<T>::await_ready() const noexcept
+	{
+		return false;
+	}
+
+	template <typename T>
+	template <typename P>
+	auto Task<T>::await_suspend(std::coroutine_handle<P> awaiting) noexcept
+	{
+		auto& promise = handle.promise();
+		promise.continuation = awaiting;
+		if constexpr (std::is_base_of_v<impl::PromiseBase, P>)
+			promise.root = awaiting.promise().root;
+		return std::coroutine_handle<>{ handle };
+	}
+
+	template <typename T>
+	T Task<T>::await_resume()
+	{
+		return handle.promise().Take();
+	}
+
+	//----------------
+	//   Event loop
+
+	inline EventLoop::~EventLoop()
+	{
+		// Coroutines that are ready belong to the frames of the roots
+		ready.clear();
+		for (Root const& root : roots)
+			root.handle.destroy();
+	}
+
+	inline void EventLoop::Post(std::coroutine_handle<> handle)
+	{
+		ready.push_back(handle);
+	}
+
+	inline auto EventLoop::Yield()
+	{
+		struct Awaiter
+		{
+			EventLoop& loop;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> h) { loop.Post(h); }
+			void await_resume() const noexcept {}
+		};
+		return Awaiter{ *this };
+	}
+
+	template <typename T>
+	void EventLoop::Spawn(Task<T> task)
+	{
+		auto const handle = std::exchange(task.handle, {});
+		roots.push_back({ handle, &handle.promise().error });
+		if (!handle.promise().started)
+			Post(handle);
+	}
+
+	inline bool EventLoop::RunOnce()
+	{
+		if (ready.empty())
+			return false;
+		auto const handle = ready.front();
+		ready.pop_front();
+		handle.resume();
+		return true;
+	}
+
+	inline size_t EventLoop::Run()
+	{
+		size_t count{};
+		while (RunOnce())
+			++count;
+
+		std::exception_ptr error{};
+		std::erase_if(roots, [&error](Root const& root)
+		{
+			if (!root.handle.done())
+				return false;
+			if (!error && *root.error)
+				error = *root.error;
+			root.handle.destroy();
+			return true;
+		});
+		if (error)
+			std::rethrow_exception(error);
+		return count;
+	}
+
+	inline size_t EventLoop::Pending() const
+	{
+		size_t count{};
+		for (Root const& root : roots)
+			count += !root.handle.done();
+		return count;
+	}
+
+}
+
+#endif
\ No newline at end of file
@@ -13,20 +13,56 @@
 #include <optional>
 #include <variant>
 
+// The profiler only when it is asked for. Without it, JL_ActionTree_Profile.h gives calls that do nothing.
+#ifdef JL_ACTION_TREE_PROFILE
+#include "JL_ActionTree_Profile.h"
+#endif
+
+// Branch hints, [[likely]] and [[unlikely]] are C++20
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#define JL_ACTION_TREE_LIKELY   [[likely]]
+#define JL_ACTION_TREE_UNLIKELY [[unlikely]]
+#else
+#define JL_ACTION_TREE_LIKELY
+#define JL_ACTION_TREE_UNLIKELY
+#endif
+
+// Functions that rarely run, kept out of the code around their call
+#if defined(__GNUC__) || defined(__clang__)
+#define JL_ACTION_TREE_COLD __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+#define JL_ACTION_TREE_COLD __declspec(noinline)
+#else
+#define JL_ACTION_TREE_COLD
+#endif
+
 namespace JL::action_tree
 {
 
-	#define TEMPLATE  template <typename T> auto
-	#define TEMPLATE2 template <typename T1, typename T2> auto
-	#define TEMPLATEV template <typename ...T> auto
+	#define TEMPLATE  template <typename T> constexpr auto
+	#define TEMPLATE2 template <typename T1, typename T2> constexpr auto
+	#define TEMPLATEV template <typename ...T> constexpr auto
 
 	namespace impl
 	{
 
+		// Nodes keep no state when none of their children do
+		template <typename T, typename ... P>
+		struct Stateless;
+
 		template <typename F>
 		struct Functor : F
 		{
+#ifdef JL_ACTION_TREE_PROFILE
+			Probe<F> probe{};
+
+			template <typename ... P>
+			constexpr auto operator () (P&& ... p)       -> decltype(std::declval<F      &>()(std::forward<P>(p)...));
+			template <typename ... P, typename = std::enable_if_t<Stateless<F, P...>::value>>
+			constexpr auto operator () (P&& ... p) const -> decltype(std::declval<F const&>()(std::forward<P>(p)...));
+#else
 			using F::operator();
+#endif
 		};
 
 		template <typename T>
@@ -38,6 +74,155 @@ namespace JL::action_tree
 		template <typename A>
 		using Maybe  = std::optional<A>;
 
+		template <typename>
+		constexpr bool dependent_false_v = false;
+
+		// Results that are awaited instead of used, nodes with such children run as a coroutine (JL_ActionTree_Async.h)
+		template <typename T, typename = void>
+		struct is_awaitable : std::false_type {};
+
+		template <typename T>
+		struct is_awaitable<T, std::void_t<decltype(std::declval<T&>().await_ready())>> : std::true_type {};
+
+#ifdef __cpp_impl_coroutine
+		template <typename T>
+		struct is_awaitable<T, std::void_t<decltype(std::declval<T&>().operator co_await())>> : std::true_type {};
+#endif
+
+		template <typename ... T>
+		constexpr bool is_awaitable_v = (is_awaitable<std::remove_reference_t<T>>::value || ...);
+
+		// Leaves keep no state when they can be called through a const reference, and do not run as a coroutine
+		template <typename T, typename ... P>
+		constexpr bool StatelessLeaf()
+		{
+			if constexpr (std::is_invocable_v<T const&, P...>)
+				return !is_awaitable_v<std::invoke_result_t<T const&, P...>>;
+			else
+				return false;
+		}
+
+		template <typename T, typename ... P>
+		struct Stateless : std::bool_constant<StatelessLeaf<T, P...>()> {};
+
+		// Arguments kept by a coroutine node: lvalues by reference, rvalues by value
+		template <typename ... P>
+		std::tuple<P...> Capture(P&& ... p)
+		{
+			return std::tuple<P...>{ std::forward<P>(p)... };
+		}
+
+		// Instance of a shared tree that is running on this thread, its nodes keep their state here (JL_ActionTree_Shared.h)
+		struct InstanceSlots
+		{
+			bool*  states;			// state of slot 0 of the instance, the next slot is `stride` further
+			size_t stride;
+
+			static inline thread_local InstanceSlots const* current{};
+		};
+
+		// Checked by the const call of every node, for a clear error before the one of the child that can not be called
+		template <typename ... P, typename N>
+		constexpr void RequireStateless(N const&);
+
+		// Which way a decision usually goes: 1 true, -1 false, 0 unknown (JL_ActionTree_Hint.h)
+		template <typename D>
+		constexpr int likelihood_v = 0;
+
+		// Runs `taken` when the test holds and `other` otherwise. The branch is hinted, the side that is
+		// rarely taken runs out of line. Needs C++20, and is not hinted in constant evaluation.
+		template <int L, typename T, typename O>
+		constexpr decltype(auto) RunHinted(bool test, T&& taken, O&& other);
+
+		template <typename F>
+		JL_ACTION_TREE_COLD decltype(auto) Cold(F&);
+
 	}
 
-}
\ No newline at end of file
+	// Trees that keep no state between calls have a const operator (), one tree can then be called by any number
+	// of threads at once, without a copy each. Edges, memos, mutable lambdas and the other nodes that remember
+	// make a tree stateful, calling it through a const reference does not compile.
+	template <typename T, typename ... P>
+	constexpr bool is_stateless_v = impl::Stateless<T, P...>::value;
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	template <typename ... P, typename N>
+	constexpr void RequireStateless(N const&)
+	{
+		static_assert(Stateless<N, P...>::value, "const operator ()  The tree keeps state: an edge, memo, mutable lambda or another node that remembers. Call it through a non-const reference, with a copy for every thread.");
+	}
+
+	template <int L, typename T, typename O>
+	constexpr decltype(auto) RunHinted(bool test, T&& taken, O&& other)
+	{
+#ifdef __cpp_lib_is_constant_evaluated
+		if constexpr (L > 0)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				if (test) JL_ACTION_TREE_LIKELY
+					return taken();
+				else
+					return Cold(other);
+			}
+		}
+		else
+		if constexpr (L < 0)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				if (test) JL_ACTION_TREE_UNLIKELY
+					return Cold(taken);
+				else
+					return other();
+			}
+		}
+#endif
+		if (test)
+			return taken();
+		else
+			return other();
+	}
+
+	template <typename F>
+	JL_ACTION_TREE_COLD decltype(auto) Cold(F& f)
+	{
+		return f();
+	}
+
+}
+
+#ifdef JL_ACTION_TREE_PROFILE
+
+namespace JL::action_tree::impl
+{
+
+	template <typename F>
+	template <typename ... P>
+	constexpr auto Functor<F>::operator()(P&& ... p) -> decltype(std::declval<F&>()(std::forward<P>(p)...))
+	{
+		if (!probe.record)
+			return static_cast<F&>(*this)(std::forward<P>(p)...);
+		return Profiled(probe.record, static_cast<F&>(*this), std::forward<P>(p)...);
+	}
+
+	template <typename F>
+	template <typename ... P, typename>
+	constexpr auto Functor<F>::operator()(P&& ... p) const -> decltype(std::declval<F const&>()(std::forward<P>(p)...))
+	{
+		if (!probe.record)
+			return static_cast<F const&>(*this)(std::forward<P>(p)...);
+		return Profiled(probe.record, static_cast<F const&>(*this), std::forward<P>(p)...);
+	}
+
+}
+
+#endif
\ No newline at end of file
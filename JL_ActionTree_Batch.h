@@ -0,0 +1,373 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Memo.h"
+#include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Switch.h"
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+#ifdef __cpp_lib_span
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	// Evaluates the tree once for every input, out[i] = tree(in[i]).
+	// 
+	// Every node runs over all inputs that reach it before the next node starts. Decisions split the inputs
+	// in the ones that took their path and the ones that did not, actions only run over the inputs that reached them.
+	// Nodes must therefore not depend on the order in which the inputs are visited.
+	// 
+	// A decision may also accept a whole batch through an overload (std::span<In const>, std::span<std::uint8_t> mask),
+	// which is used whenever the inputs that reach it are contiguous.
+	template <typename T, typename In, typename Out>
+	void EvaluateBatch(Action<T>&, std::span<In const>, std::span<Out>);
+
+	template <typename T, typename In>
+	void EvaluateBatch(Action<T>&, std::span<In const>);
+
+	template <typename T, typename In>
+	void EvaluateBatch(Decision<T>&, std::span<In const>, std::span<bool>);
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	using BatchIndex = std::uint32_t;
+
+	// Buffers are handed back to a pool of the thread when released, so repeated batches do not allocate.
+	class BatchPool
+	{
+	public:
+
+		struct Buffer
+		{
+			std::unique_ptr<BatchIndex[]> data;
+			size_t                        capacity;
+		};
+
+		static Buffer Acquire(size_t size)
+		{
+			auto& pool = Local();
+			for (size_t i{ pool.size() }; i-- > 0;)
+				if (pool[i].capacity >= size)
+				{
+					Buffer out = std::move(pool[i]);
+					pool.erase(pool.begin() + i);
+					return out;
+				}
+			return { std::unique_ptr<BatchIndex[]>{ new BatchIndex[size] }, size };
+		}
+
+		static void Release(Buffer buffer)
+		{
+			if (buffer.data)
+				Local().push_back(std::move(buffer));
+		}
+
+	private:
+
+		static std::vector<Buffer>& Local()
+		{
+			thread_local std::vector<Buffer> pool;
+			return pool;
+		}
+	};
+
+	// Sorted list of input indices, left uninitialised on construction
+	struct Indices
+	{
+		BatchPool::Buffer buffer{};
+		size_t            count{};
+
+		Indices() = default;
+		explicit Indices(size_t size) : buffer{ BatchPool::Acquire(size) }, count{ size } {}
+		~Indices() { BatchPool::Release(std::move(buffer)); }
+
+		Indices(Indices&&) noexcept = default;
+		Indices& operator = (Indices&& other) noexcept
+		{
+			BatchPool::Release(std::exchange(buffer, std::move(other.buffer)));
+			count = other.count;
+			return *this;
+		}
+
+		size_t      size () const noexcept { return count; }
+		bool        empty() const noexcept { return count == 0; }
+		BatchIndex* begin() const noexcept { return buffer.data.get(); }
+		BatchIndex* end  () const noexcept { return buffer.data.get() + count; }
+		BatchIndex  front() const noexcept { return buffer.data[0]; }
+		BatchIndex  back () const noexcept { return buffer.data[count - 1]; }
+
+		BatchIndex& operator [] (size_t i) const noexcept { return buffer.data[i]; }
+
+		static Indices Iota(size_t size)
+		{
+			Indices out(size);
+			for (size_t i{}; i < size; ++i)
+				out[i] = BatchIndex(i);
+			return out;
+		}
+	};
+
+	struct Partition
+	{
+		Indices taken;
+		Indices rest;
+	};
+
+	template <typename M>
+	Partition Compact(Indices const& indices, M&& mask)
+	{
+		size_t const size = indices.size();
+
+		Partition out{ Indices(size), Indices(size) };
+		size_t taken{}, rest{};
+		for (size_t k{}; k < size; ++k)
+		{
+			size_t const m = mask(k, indices[k]);
+			out.taken[taken] = indices[k];
+			out.rest [rest ] = indices[k];
+			taken += m;
+			rest  += 1 - m;
+		}
+		out.taken.count = taken;
+		out.rest .count = rest;
+		return out;
+	}
+
+	inline Indices Merge(Indices const& a, Indices const& b)
+	{
+		Indices out(a.size() + b.size());
+		std::merge(a.begin(), a.end(), b.begin(), b.end(), out.begin());
+		return out;
+	}
+
+	//--------------
+	//   Decisions
+
+	template <typename T, typename In>
+	Partition SplitBatch(Decision<T>& decision, std::span<In const> in, Indices const& indices)
+	{
+		using Batch = std::span<In const>;
+		using Mask  = std::span<std::uint8_t>;
+		if constexpr (std::is_invocable_v<Decision<T>&, Batch, Mask>)
+		{
+			if (!indices.empty() && size_t(indices.back() - indices.front()) + 1 == indices.size())
+			{
+				Indices mask((indices.size() + sizeof(BatchIndex) - 1) / sizeof(BatchIndex));
+				auto const bytes = reinterpret_cast<std::uint8_t*>(mask.begin());
+
+				decision(in.subspan(indices.front(), indices.size()), Mask{ bytes, indices.size() });
+				return Compact(indices, [bytes](size_t k, BatchIndex) { return bytes[k] != 0; });
+			}
+		}
+
+		return Compact(indices, [&](size_t, BatchIndex i) { return bool(decision(in[i])); });
+	}
+
+	template <typename D, typename In>
+	Partition SplitBatch(Decision<Not<D>>& decision, std::span<In const> in, Indices const& indices)
+	{
+		auto out = SplitBatch(decision.decision, in, indices);
+		std::swap(out.taken, out.rest);
+		return out;
+	}
+
+	// Memoization is paused during a batch, the decision inside may still handle the batch itself
+	template <typename D, typename In>
+	Partition SplitBatch(Decision<Memoized<D>>& decision, std::span<In const> in, Indices const& indices)
+	{
+		return SplitBatch(decision.decision, in, indices);
+	}
+
+	template <typename A, typename B, typename In>
+	Partition SplitBatch(Decision<And<A, B>>& decision, std::span<In const> in, Indices const& indices)
+	{
+		auto a = SplitBatch(decision.a, in, indices);
+		auto b = SplitBatch(decision.b, in, a.taken);
+		return { std::move(b.taken), Merge(a.rest, b.rest) };
+	}
+
+	template <typename A, typename B, typename In>
+	Partition SplitBatch(Decision<Or<A, B>>& decision, std::span<In const> in, Indices const& indices)
+	{
+		auto a = SplitBatch(decision.a, in, indices);
+		auto b = SplitBatch(decision.b, in, a.rest);
+		return { Merge(a.taken, b.taken), std::move(b.rest) };
+	}
+
+	//------------
+	//   Actions
+
+	template <typename A, typename In>
+	using BatchResult_t = decltype(std::declval<A&>()(std::declval<In const&>()));
+
+	// Runs an action over the indices and passes its results to sink(index, result), sink is not called for void.
+	template <typename T, typename In, typename S>
+	void RunBatch(Action<T>& action, std::span<In const> in, Indices const& indices, S&& sink)
+	{
+		for (BatchIndex const i : indices)
+		{
+			if constexpr (std::is_void_v<BatchResult_t<Action<T>, In>>)
+				action(in[i]);
+			else
+				sink(i, action(in[i]));
+		}
+	}
+
+	// Runs the action of a branch and moves its results into the slot of the stack result
+	template <typename R, typename A, typename In, typename S>
+	void RunBatchInto(A& action, std::span<In const> in, Indices const& indices, S& sink)
+	{
+		using Ra = BatchResult_t<A, In>;
+		if constexpr (std::is_void_v<R>)
+			RunBatch(action, in, indices, sink);
+		else
+		if constexpr (std::is_void_v<Ra>)
+		{
+			RunBatch(action, in, indices, sink);
+			for (BatchIndex const i : indices)
+				sink(i, EmptyResult<R>());
+		}
+		else
+			RunBatch(action, in, indices, [&sink](BatchIndex i, auto&& r) { sink(i, WrapResult<R, Ra>(std::forward<decltype(r)>(r))); });
+	}
+
+	template <typename D, typename A, typename In, typename S>
+	void RunBatch(Action<Conditional<D, A>>& node, std::span<In const> in, Indices const& indices, S&& sink)
+	{
+		using R = BatchResult_t<A, In>;
+
+		auto split = SplitBatch(node.decision, in, indices);
+		if constexpr (std::is_void_v<R>)
+			RunBatch(node.action, in, split.taken, sink);
+		else
+		{
+			RunBatchInto<Maybe<R>>(node.action, in, split.taken, sink);
+			for (BatchIndex const i : split.rest)
+				sink(i, Maybe<R>{});
+		}
+	}
+
+	template <typename A, typename ... B, typename In, typename S>
+	void RunBatch(Action<Cascade<A, B...>>& node, std::span<In const> in, Indices const& indices, S&& sink)
+	{
+		using R = BatchResult_t<Action<Cascade<A, B...>>, In>;
+
+		Indices remaining(indices.size());
+		std::copy(indices.begin(), indices.end(), remaining.begin());
+		std::apply(
+			[&](auto& ... branch)
+			{
+				auto run = [&](auto& branch)
+				{
+					auto split = SplitBatch(branch.decision, in, remaining);
+					RunBatchInto<R>(branch.action, in, split.taken, sink);
+					remaining = std::move(split.rest);
+				};
+				(run(branch), ...);
+			},
+			node.branches
+		);
+		RunBatchInto<R>(node.fallback, in, remaining, sink);
+	}
+
+	template <typename K, typename A, typename ... C, typename In, typename S>
+	void RunBatch(Action<SwitchDispatch<K, A, C...>>& node, std::span<In const> in, Indices const& indices, S&& sink)
+	{
+		using R     = BatchResult_t<Action<SwitchDispatch<K, A, C...>>, In>;
+		using Table = SwitchTable<C...>;
+
+		// Bucket the inputs per case, in order. The case of every input goes in a buffer of the pool as well.
+		Indices index(indices.size());
+		for (size_t k{}; k < indices.size(); ++k)
+			index[k] = BatchIndex(Table::Find(SwitchKey(node.key(in[indices[k]]))));
+
+		std::array<Indices, sizeof...(C) + 1> buckets{};
+		std::array<size_t , sizeof...(C) + 1> counts {};
+		for (size_t k{}; k < indices.size(); ++k)
+			++counts[index[k]];
+		for (size_t c{}; c < buckets.size(); ++c)
+			buckets[c] = Indices(counts[c]), buckets[c].count = 0;
+		for (size_t k{}; k < indices.size(); ++k)
+		{
+			auto& bucket = buckets[index[k]];
+			bucket[bucket.count++] = indices[k];
+		}
+
+		[&]<size_t ... I>(std::index_sequence<I...>)
+		{
+			(RunBatchInto<R>(std::get<I>(node.cases).action, in, buckets[I], sink), ...);
+		}
+		(std::index_sequence_for<C...>{});
+		RunBatchInto<R>(node.fallback, in, buckets[sizeof...(C)], sink);
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename T, typename In, typename Out>
+	void EvaluateBatch(Action<T>& tree, std::span<In const> in, std::span<Out> out)
+	{
+		impl::MemoPause const pause{};
+		auto const indices = impl::Indices::Iota(in.size());
+
+		impl::RunBatch(tree, in, indices,
+			[&out](impl::BatchIndex i, auto&& result)
+			{
+				out[i] = std::forward<decltype(result)>(result);
+			}
+		);
+	}
+
+	template <typename T, typename In>
+	void EvaluateBatch(Action<T>& tree, std::span<In const> in)
+	{
+		impl::MemoPause const pause{};
+		auto const indices = impl::Indices::Iota(in.size());
+
+		impl::RunBatch(tree, in, indices, [](impl::BatchIndex, auto&&) {});
+	}
+
+	template <typename T, typename In>
+	void EvaluateBatch(Decision<T>& decision, std::span<In const> in, std::span<bool> out)
+	{
+		impl::MemoPause const pause{};
+		auto const indices = impl::Indices::Iota(in.size());
+
+		auto split = impl::SplitBatch(decision, in, indices);
+		for (impl::BatchIndex const i : split.taken)
+			out[i] = true;
+		for (impl::BatchIndex const i : split.rest)
+			out[i] = false;
+	}
+
+}
+
+#endif
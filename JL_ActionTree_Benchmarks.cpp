@@ -0,0 +1,865 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#include "JL_ActionTree.h"
+using namespace JL::action_tree;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "../catch2/catch.hpp"
+
+#pragma region bench_utilities
+
+// A tree that is too large for the small buffer of std::function
+auto makeTree(int seed)
+{
+	Decision isEven  { [seed](int i) { return ((i + seed) & 1) == 0; } };
+	Action   scale   { [seed](int i) { return i * seed; } };
+	Action   offset  { [seed](int i) { return i + seed; } };
+	Action   negate  { [seed](int i) { return seed - i; } };
+
+	return isEven && std::move(scale) | std::move(offset) || std::move(negate);
+}
+
+auto equals = [](int i) { return Decision{ [i](int j) { return i == j; } }; };
+auto triple = [](int i) { return Action  { [i](int)   { return i * 3;  } }; };
+
+template <size_t ... I>
+auto makeStack(std::index_sequence<I...>)
+{
+	return ((... || (equals(int(I)) && triple(int(I)))) || triple(-1));
+}
+
+template <size_t ... I>
+auto makeSwitch(std::index_sequence<I...>)
+{
+	Action key{ [](int i) { return i; } };
+	return Switch{ key, on<int(I)>(triple(int(I)))... } || triple(-1);
+}
+
+template <size_t ... I>
+auto makeSparseSwitch(std::index_sequence<I...>)
+{
+	Action key{ [](int i) { return i * 7919; } };
+	return Switch{ key, on<int(I) * 7919>(triple(int(I)))... } || triple(-1);
+}
+
+// All of `count` inputs are in range, as a balanced tree of &
+template <size_t Count, typename L>
+auto makeAllOf(L leaf, size_t first = 0)
+{
+	if constexpr (Count == 1)
+		return leaf(first);
+	else
+		return makeAllOf<Count / 2>(leaf, first) & makeAllOf<Count / 2>(leaf, first + Count / 2);
+}
+
+#pragma endregion
+
+TEST_CASE("Benchmark dynamic action")
+{
+
+	using Tree = decltype(makeTree(0));
+
+	BENCHMARK("std::function construct")
+	{
+		return ActionDynamic<int(int)>{ makeTree(3) };
+	};
+
+	BENCHMARK("inplace construct")
+	{
+		return ActionDynamicInplace<int(int), sizeof(Tree)>{ makeTree(3) };
+	};
+
+	BENCHMARK("move only construct")
+	{
+		return ActionDynamicMoveOnly<int(int), sizeof(Tree)>{ makeTree(3) };
+	};
+
+	BENCHMARK_ADVANCED("std::function assign")(Catch::Benchmark::Chronometer meter)
+	{
+		std::vector<ActionDynamic<int(int)>> acts(meter.runs());
+		meter.measure([&](int i) { acts[i] = makeTree(i); });
+	};
+
+	BENCHMARK_ADVANCED("inplace assign")(Catch::Benchmark::Chronometer meter)
+	{
+		std::vector<ActionDynamicInplace<int(int), sizeof(Tree)>> acts(meter.runs());
+		meter.measure([&](int i) { acts[i] = makeTree(i); });
+	};
+
+	BENCHMARK_ADVANCED("move only assign")(Catch::Benchmark::Chronometer meter)
+	{
+		std::vector<ActionDynamicMoveOnly<int(int), sizeof(Tree)>> acts(meter.runs());
+		meter.measure([&](int i) { acts[i] = makeTree(i); });
+	};
+
+	{
+
+		ActionDynamic        <int(int)>               function{ makeTree(3) };
+		ActionDynamicInplace <int(int), sizeof(Tree)> inplace { makeTree(3) };
+		ActionDynamicMoveOnly<int(int), sizeof(Tree)> moveOnly{ makeTree(3) };
+
+		BENCHMARK("std::function call")
+		{
+			int sum{};
+			for (int i{}; i < 1000; ++i)
+				sum += function(i);
+			return sum;
+		};
+
+		BENCHMARK("inplace call")
+		{
+			int sum{};
+			for (int i{}; i < 1000; ++i)
+				sum += inplace(i);
+			return sum;
+		};
+
+		BENCHMARK("move only call")
+		{
+			int sum{};
+			for (int i{}; i < 1000; ++i)
+				sum += moveOnly(i);
+			return sum;
+		};
+
+	}
+
+}
+
+
+TEST_CASE("Benchmark switch")
+{
+
+	auto stack  = makeStack       (std::make_index_sequence<64>{});
+	auto dense  = makeSwitch      (std::make_index_sequence<64>{});
+	auto sparse = makeSparseSwitch(std::make_index_sequence<64>{});
+
+	for (int i{ -1 }; i < 70; ++i)
+	{
+		REQUIRE(stack(i) == dense (i));
+		REQUIRE(stack(i) == sparse(i));
+	}
+
+	BENCHMARK("64 case || stack")
+	{
+		int sum{};
+		for (int i{}; i < 1000; ++i)
+			sum += stack(i % 70);
+		return sum;
+	};
+
+	BENCHMARK("64 case dense switch")
+	{
+		int sum{};
+		for (int i{}; i < 1000; ++i)
+			sum += dense(i % 70);
+		return sum;
+	};
+
+	BENCHMARK("64 case sparse switch")
+	{
+		int sum{};
+		for (int i{}; i < 1000; ++i)
+			sum += sparse(i % 70);
+		return sum;
+	};
+
+}
+
+TEST_CASE("Benchmark adaptive decisions")
+{
+
+	// Written in the worst order: the expensive operand that is nearly always true comes first
+	Decision slow{ [](int i) { int h{ i }; for (int r{}; r < 64; ++r) h = h * 31 + r; return (h & 255) != 0; } };
+	Decision rare{ [](int i) { return i % 16 == 0; } };
+
+	auto plain    = slow & rare;
+	auto adaptive = Adaptive(slow & rare);
+
+	for (int i{}; i < 4096; ++i)
+		REQUIRE(plain(i) == adaptive(i));
+
+	BENCHMARK("written order")
+	{
+		int sum{};
+		for (int i{}; i < 1000; ++i)
+			sum += plain(i);
+		return sum;
+	};
+
+	BENCHMARK("adaptive order")
+	{
+		int sum{};
+		for (int i{}; i < 1000; ++i)
+			sum += adaptive(i);
+		return sum;
+	};
+
+}
+
+TEST_CASE("Benchmark blackboard")
+{
+
+	// Six values every node could need, by parameter list and from a blackboard
+	struct Health : Entry<int> {};
+	struct Ammo   : Entry<int> {};
+	struct Range  : Entry<float> {};
+	struct Speed  : Entry<float> {};
+	struct Target : Entry<int> {};
+	struct Score  : Entry<int> {};
+
+	using Params = std::tuple<int, int, float, float, int, int>;
+	std::vector<Params> params(1000);
+	std::vector<Blackboard<Health, Ammo, Range, Speed, Target, Score>> boards(1000);
+	for (int i{}; i < 1000; ++i)
+	{
+		params[i] = { i % 100, i % 7, float(i % 50), 1.f, i, 0 };
+		auto& board = boards[i];
+		board.Get<Health>() = i % 100;
+		board.Get<Ammo>()   = i % 7;
+		board.Get<Range>()  = float(i % 50);
+		board.Get<Speed>()  = 1.f;
+		board.Get<Target>() = i;
+	}
+
+	Decision isHurtP { [](int health, int, float, float, int, int&) { return health < 30; } };
+	Decision hasAmmoP{ [](int, int ammo, float, float, int, int&) { return ammo > 0; } };
+	Decision inRangeP{ [](int, int, float range, float, int, int&) { return range < 25; } };
+	Action   shootP  { [](int, int, float, float, int target, int& score) { return score += target; } };
+	Action   chaseP  { [](int, int, float range, float speed, int, int& score) { return score += int(range * speed); } };
+	Action   fleeP   { [](int health, int, float, float, int, int& score) { return score -= health; } };
+	auto byParams = isHurtP && fleeP || hasAmmoP && (inRangeP && shootP || chaseP) || fleeP;
+
+	Decision isHurtB { Uses<Health>([](int health) { return health < 30; }) };
+	Decision hasAmmoB{ Uses<Ammo>  ([](int ammo) { return ammo > 0; }) };
+	Decision inRangeB{ Uses<Range> ([](float range) { return range < 25; }) };
+	Action   shootB  { Uses<Target, Score>([](int target, int& score) { return score += target; }) };
+	Action   chaseB  { Uses<Range, Speed, Score>([](float range, float speed, int& score) { return score += int(range * speed); }) };
+	Action   fleeB   { Uses<Health, Score>([](int health, int& score) { return score -= health; }) };
+	auto byBoard = isHurtB && fleeB || hasAmmoB && (inRangeB && shootB || chaseB) || fleeB;
+
+	BENCHMARK("parameter list")
+	{
+		int sum{};
+		for (auto& [health, ammo, range, speed, target, score] : params)
+			sum += byParams(health, ammo, range, speed, target, score);
+		return sum;
+	};
+
+	BENCHMARK("blackboard")
+	{
+		int sum{};
+		for (auto& board : boards)
+			sum += byBoard(board);
+		return sum;
+	};
+
+}
+
+TEST_CASE("Benchmark resumable tree")
+{
+
+	// 8 branches, the last one walks a path of 4 steps that each take 16 ticks.
+	// From the root, every tick asks all decisions again and runs the steps that are done as a check.
+	std::vector<int> progress(4);
+	auto step = [&progress](size_t i)
+	{
+		return Action{ [&progress, i](int) { return progress[i] < 16 ? (++progress[i], Status::Running) : Status::Success; } };
+	};
+	auto never = [](int i) { return Decision{ [i](int j) { return j == i * 100; } }; };
+	Action idle{ [](int) { return Status::Success; } };
+
+	// A plain sequence gathers the statuses instead of stopping, so the path is written out by hand for the baseline
+	Action path{ [steps = std::array{ step(0), step(1), step(2), step(3) }](int t) mutable
+	{
+		for (auto& s : steps)
+			if (Status status = s(t); status != Status::Success)
+				return status;
+		return Status::Success;
+	} };
+
+	auto stack = never(1) && idle || never(2) && idle || never(3) && idle || never(4) && idle
+	          || never(5) && idle || never(6) && idle || never(7) && idle;
+
+	auto fromRoot  = stack || path;
+	auto resumable = Resumable(stack || (step(0) | step(1) | step(2) | step(3)));
+
+	BENCHMARK("from the root every tick")
+	{
+		std::fill(progress.begin(), progress.end(), 0);
+		int ticks{};
+		while (fromRoot(ticks) == Status::Running)
+			++ticks;
+		return ticks;
+	};
+
+	BENCHMARK("resumed at the running node")
+	{
+		std::fill(progress.begin(), progress.end(), 0);
+		int ticks{};
+		while (resumable(ticks) == Status::Running)
+			++ticks;
+		return ticks;
+	};
+
+}
+
+TEST_CASE("Benchmark reactive tree")
+{
+
+	// 1024 inputs that all have to be in range, 1% of them changes every tick
+	constexpr size_t inputs = 1024;
+	std::vector<int> values(inputs, 1);
+	std::vector<size_t> changes(inputs / 100);
+
+	size_t tick{};
+	auto change = [&]
+	{
+		for (auto& i : changes)
+		{
+			i = (++tick * 7919) % inputs;
+			values[i] = int(tick % 999) + 1;
+		}
+	};
+
+	Action act{ [](int) { return 1; } };
+
+	// A comparison, and a check against 8 obstacles, as a stand-in for a decision with some work to do
+	auto inRange = [&values](size_t i) { return Decision{ [&values, i](int) { return values[i] > 0 && values[i] < 1000; } }; };
+	auto inSight = [&values](size_t i)
+	{
+		return Decision{ [&values, i](int)
+		{
+			int blocked{};
+			for (int obstacle{ 1 }; obstacle <= 8; ++obstacle)
+				blocked += values[i] % (obstacle + 10) == 0;
+			return blocked < 8;
+		} };
+	};
+
+	auto cheap        = makeAllOf<inputs>(inRange) & act;
+	auto cheapReact   = Reactive(makeAllOf<inputs>([&](size_t i) { return Reads(inRange(i), i); }) & act);
+	auto costly       = makeAllOf<inputs>(inSight) & act;
+	auto costlyReact  = Reactive(makeAllOf<inputs>([&](size_t i) { return Reads(inSight(i), i); }) & act);
+
+	BENCHMARK("comparisons, every decision")
+	{
+		change();
+		return cheap(0).value_or(0);
+	};
+
+	BENCHMARK("comparisons, touched decisions only")
+	{
+		change();
+		for (size_t i : changes)
+			cheapReact.Touch(i);
+		return cheapReact(0).value_or(0);
+	};
+
+	BENCHMARK("line of sight, every decision")
+	{
+		change();
+		return costly(0).value_or(0);
+	};
+
+	BENCHMARK("line of sight, touched decisions only")
+	{
+		change();
+		for (size_t i : changes)
+			costlyReact.Touch(i);
+		return costlyReact(0).value_or(0);
+	};
+
+}
+
+TEST_CASE("Benchmark script")
+{
+
+	// 8 case branch stack, and an edge triggered sequence, composed and parsed
+	Registry<int(int)> registry{};
+	std::string names{};
+	for (int i{}; i < 8; ++i)
+	{
+		registry.Add("is" + std::to_string(i), equals(i));
+		registry.Add("triple" + std::to_string(i), triple(i));
+		names += "is" + std::to_string(i) + " && triple" + std::to_string(i) + " || ";
+	}
+	registry.Add("fallback", triple(-1));
+
+	Decision isHigh{ [](int i) { return i > 4; } };
+	Action   rise  { [](int i) { return i + 1; } };
+	Action   fall  { [](int i) { return i - 1; } };
+	Action   work  { [](int i) { return i * 3; } };
+	registry.Add("isHigh", isHigh);
+	registry.Add("rise", rise);
+	registry.Add("fall", fall);
+	registry.Add("work", work);
+
+	auto stack        = makeStack(std::make_index_sequence<8>{});
+	auto stackScript  = registry.ParseAction(names + "fallback");
+	auto edges        = isHigh +rise -fall & work | work;
+	auto edgesScript  = registry.ParseAction("isHigh +rise -fall & work | work");
+
+	std::vector<int> input(1000);
+	for (size_t i{}; i < input.size(); ++i)
+		input[i] = int((i * 7919) % 10);
+
+	BENCHMARK("8 case stack, composed")
+	{
+		int sum{};
+		for (int i : input)
+			sum += stack(i);
+		return sum;
+	};
+
+	BENCHMARK("8 case stack, script")
+	{
+		int sum{};
+		for (int i : input)
+			sum += *stackScript(i);
+		return sum;
+	};
+
+	BENCHMARK("edges, composed")
+	{
+		int sum{};
+		for (int i : input)
+		{
+			auto [a, b] = edges(i);
+			sum += a.value_or(0) + b;
+		}
+		return sum;
+	};
+
+	BENCHMARK("edges, script")
+	{
+		int sum{};
+		for (int i : input)
+			sum += *edgesScript(i);
+		return sum;
+	};
+
+}
+
+TEST_CASE("Benchmark folded tree")
+{
+
+	// Price of an item, from 6 decisions on its id
+	constexpr Decision isRare  { [](int id) { return id % 17 == 0; } };
+	constexpr Decision isBulk  { [](int id) { return id >= 200; } };
+	constexpr Decision isTool  { [](int id) { return id / 16 % 4 == 1; } };
+	constexpr Decision isFood  { [](int id) { return id / 16 % 4 == 2; } };
+	constexpr Decision isStale { [](int id) { return id % 5 == 0; } };
+	constexpr Decision isLegacy{ [](int id) { return id < 8; } };
+
+	constexpr Action rare { [](int id) { return 500 + id * 3; } };
+	constexpr Action bulk { [](int id) { return 2 + id % 3; } };
+	constexpr Action tool { [](int id) { return 40 + id % 7; } };
+	constexpr Action food { [](int id) { return 5 + id % 4; } };
+	constexpr Action plain{ [](int id) { return 10 + id % 9; } };
+
+	constexpr auto price = isRare && rare || isLegacy && rare || isBulk && bulk || isTool & !isStale && tool || isFood && food || plain;
+	static constexpr auto table = Tabulate<256, int>(price);
+
+	std::vector<int> ids(1024);
+	for (size_t i{}; i < ids.size(); ++i)
+		ids[i] = int(i * 7919 % 256);
+
+	auto tree = price;
+
+	BENCHMARK("tree")
+	{
+		int total{};
+		for (int id : ids)
+			total += tree(id);
+		return total;
+	};
+
+	BENCHMARK("table")
+	{
+		int total{};
+		for (int id : ids)
+			total += table[id];
+		return total;
+	};
+
+}
+
+TEST_CASE("Benchmark hinted tree")
+{
+
+	// A hot loop with a rare, bulky error path in front of it
+	Decision isCorrupt{ [](uint32_t v) { return v % 4096 == 0; } };
+	Decision isOdd    { [](uint32_t v) { return v & 1; } };
+	Action   repair   { [](uint32_t v)
+	{
+		uint32_t table[64]{};
+		for (uint32_t i{}; i < 64; ++i)
+			table[i] = (v ^ i * 2654435761u) >> (i % 7);
+		uint32_t sum{};
+		for (uint32_t i{}; i < 64; ++i)
+			sum += table[(sum + i) % 64] * (i | 1);
+		return sum;
+	} };
+	Action   odd      { [](uint32_t v) { return v * 3 + 1; } };
+	Action   even     { [](uint32_t v) { return v / 2; } };
+
+	std::vector<uint32_t> values(4096);
+	for (size_t i{}; i < values.size(); ++i)
+		values[i] = uint32_t(i * 2654435761u);
+
+	auto plain  = isCorrupt && repair || isOdd && odd || even;
+	auto hinted = Unlikely(isCorrupt) && repair || isOdd && odd || even;
+
+	BENCHMARK("plain")
+	{
+		uint32_t total{};
+		for (uint32_t v : values)
+			total += plain(v);
+		return total;
+	};
+
+	BENCHMARK("hinted")
+	{
+		uint32_t total{};
+		for (uint32_t v : values)
+			total += hinted(v);
+		return total;
+	};
+
+}
+
+TEST_CASE("Benchmark truth table")
+{
+
+	// 6 decisions that look up a flag of an item, each holds half of the time, so the branches of the stack can not be predicted
+	std::vector<uint8_t> flags(1024);
+	uint32_t seed{ 12345 };
+	for (auto& f : flags)
+		f = uint8_t((seed = seed * 1664525u + 1013904223u) >> 24);
+
+	Decision b0{ [&flags](uint32_t id) { return flags[id] >> 0 & 1; } };
+	Decision b1{ [&flags](uint32_t id) { return flags[id] >> 1 & 1; } };
+	Decision b2{ [&flags](uint32_t id) { return flags[id] >> 2 & 1; } };
+	Decision b3{ [&flags](uint32_t id) { return flags[id] >> 3 & 1; } };
+	Decision b4{ [&flags](uint32_t id) { return flags[id] >> 4 & 1; } };
+	Decision b5{ [&flags](uint32_t id) { return flags[id] >> 5 & 1; } };
+
+	Action a0{ [](uint32_t id) { return id + 1; } };
+	Action a1{ [](uint32_t id) { return id * 3; } };
+	Action a2{ [](uint32_t id) { return id ^ 0x55; } };
+	Action a3{ [](uint32_t id) { return id >> 2; } };
+	Action a4{ [](uint32_t id) { return id - 7; } };
+	Action a5{ [](uint32_t id) { return id << 1; } };
+	Action a6{ [](uint32_t id) { return ~id; } };
+
+	auto stack = b0 && a0 || b1 && a1 || b2 && a2 || b3 && a3 || b4 && a4 || b5 && a5 || a6;
+	auto table = TruthTable(stack);
+
+	std::vector<uint32_t> ids(4096);
+	for (size_t i{}; i < ids.size(); ++i)
+		ids[i] = uint32_t(i * 7919 % flags.size());
+
+	BENCHMARK("stack")
+	{
+		uint32_t total{};
+		for (uint32_t id : ids)
+			total += stack(id);
+		return total;
+	};
+
+	BENCHMARK("truth table")
+	{
+		uint32_t total{};
+		for (uint32_t id : ids)
+			total += table(id);
+		return total;
+	};
+
+	// The first decision nearly always holds: the stack predicts well and stops after one decision
+	for (auto& f : flags)
+		f |= 1;
+
+	BENCHMARK("stack, predictable")
+	{
+		uint32_t total{};
+		for (uint32_t id : ids)
+			total += stack(id);
+		return total;
+	};
+
+	BENCHMARK("truth table, predictable")
+	{
+		uint32_t total{};
+		for (uint32_t id : ids)
+			total += table(id);
+		return total;
+	};
+
+}
+
+TEST_CASE("Benchmark hot swap")
+{
+
+	// The same subtree behind a firewall and behind a hot swap
+	auto subtree = makeTree(3);
+	auto firewall = Firewall<int(int)>(subtree);
+
+	HotSwap<int(int)> swap{ makeTree(3) };
+	auto live = Live(swap);
+
+	BENCHMARK("firewall")
+	{
+		int total{};
+		for (int i{}; i < 1024; ++i)
+			total += firewall(i);
+		return total;
+	};
+
+	BENCHMARK("hot swap")
+	{
+		int total{};
+		for (int i{}; i < 1024; ++i)
+			total += live(i);
+		return total;
+	};
+
+	// Latency of single calls on 4 threads, while the subtree is not swapped and while it is swapped continuously.
+	// Buckets are powers of two in nanoseconds.
+	using Clock = std::chrono::steady_clock;
+	constexpr size_t buckets = 24;
+
+	auto histogram = [&](bool swapping)
+	{
+		std::array<std::atomic<uint64_t>, buckets> counts{};
+		std::atomic<bool> done{};
+
+		std::vector<std::thread> readers{};
+		for (int r{}; r < 4; ++r)
+			readers.emplace_back([&]
+			{
+				auto reader = live;
+				for (int i{}; !done.load(std::memory_order_relaxed); ++i)
+				{
+					auto const begin = Clock::now();
+					reader(i);
+					auto const ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+
+					size_t bucket{};
+					while (bucket + 1 < buckets && (uint64_t{ 2 } << bucket) <= ns)
+						++bucket;
+					counts[bucket].fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+
+		size_t swaps{};
+		for (auto const end = Clock::now() + std::chrono::milliseconds{ 200 }; Clock::now() < end; ++swaps)
+			if (swapping)
+				swap.Swap(makeTree(int(swaps % 7) + 1));
+			else
+				std::this_thread::yield();
+
+		done = true;
+		for (auto& reader : readers)
+			reader.join();
+
+		std::printf("\nCalls %s:\n", swapping ? "during swaps" : "without swaps");
+		if (swapping)
+			std::printf("  %zu swaps\n", swaps);
+		for (size_t bucket{}; bucket < buckets; ++bucket)
+			if (uint64_t const count = counts[bucket])
+				std::printf("  < %9llu ns  %10llu\n", (unsigned long long)(uint64_t{ 2 } << bucket), (unsigned long long)count);
+	};
+
+	histogram(false);
+	histogram(true);
+
+}
+
+TEST_CASE("Benchmark shared tree")
+{
+
+	// 100k entities, each with edges of its own
+	constexpr size_t entities = 100000;
+
+	auto makeEntityTree = []
+	{
+		Decision isHigh{ [](int i) { return i >= 500; } };
+		Action   rise  { [scale = 3](int i) { return i * scale; } };
+		Action   fall  { [scale = 5](int i) { return i * scale; } };
+		Action   work  { [offset = 7](int i) { return i + offset; } };
+		return (isHigh +rise -fall) & work;
+	};
+
+	std::vector<int> input(entities);
+	for (size_t e{}; e < entities; ++e)
+		input[e] = int((e * 7919) % 1000);
+
+	std::vector<decltype(makeEntityTree())> copies(entities, makeEntityTree());
+	auto shared = Share(makeEntityTree());
+	auto states = shared.States(entities);
+
+	BENCHMARK("100k copies of a tree")
+	{
+		int sum{};
+		for (size_t e{}; e < entities; ++e)
+			sum += copies[e](input[e]).value_or(0);
+		return sum;
+	};
+
+	BENCHMARK("one tree, 100k states")
+	{
+		int sum{};
+		for (size_t e{}; e < entities; ++e)
+			sum += shared(states, e, input[e]).value_or(0);
+		return sum;
+	};
+
+}
+
+TEST_CASE("Benchmark parallel sequence")
+{
+
+	// CPU bound, independent work
+	auto work = [](int seed)
+	{
+		return Action{ [seed](int n)
+		{
+			std::uint64_t x = std::uint64_t(seed);
+			for (int i{}; i < n; ++i)
+				x = x * 6364136223846793005ull + 1442695040888963407ull;
+			return x;
+		} };
+	};
+
+	auto sequence = work(1) | work(2) | work(3) | work(4);
+	auto parallel = Parallel(work(1), work(2), work(3), work(4));
+
+	REQUIRE(sequence(1000) == parallel(1000));
+
+	BENCHMARK("4 actions in sequence")
+	{
+		return sequence(1'000'000);
+	};
+
+	BENCHMARK("4 actions in parallel")
+	{
+		return parallel(1'000'000);
+	};
+
+}
+
+TEST_CASE("Benchmark pipeline")
+{
+
+	// Three CPU bound stages, each one works on the result of the one before
+	auto stage = [](int rounds)
+	{
+		return Action{ [rounds](std::uint64_t x)
+		{
+			for (int i{}; i < rounds; ++i)
+				x = x * 6364136223846793005ull + 1442695040888963407ull;
+			return x;
+		} };
+	};
+
+	auto a = stage(200), b = stage(200), c = stage(200);
+	constexpr std::uint64_t items{ 10'000 };
+
+	BENCHMARK("10k items, serial")
+	{
+		std::uint64_t sum{};
+		for (std::uint64_t i{}; i < items; ++i)
+			sum += c(b(a(i)));
+		return sum;
+	};
+
+	BENCHMARK("10k items, pipeline")
+	{
+		std::uint64_t sum{};
+		auto pipeline = Pipeline<std::uint64_t>(a, b, c | JL::Visitor{ [&sum](std::uint64_t x) { sum += x; } });
+		for (std::uint64_t i{}; i < items; ++i)
+			pipeline.Push(i);
+		pipeline.Wait();
+		return sum;
+	};
+
+}
+
+#ifdef __cpp_lib_span
+
+TEST_CASE("Benchmark batch evaluation")
+{
+
+	struct Entity
+	{
+		float health;
+		float distance;
+	};
+
+	std::vector<Entity> entities(10000);
+	for (size_t i{}; i < entities.size(); ++i)
+		entities[i] = { float((i * 7919) % 100), float((i * 104729) % 50) };
+
+	Decision isHurt { [](Entity const& e) { return e.health < 30.f; } };
+	Decision isClose{ [](Entity const& e) { return e.distance < 10.f; } };
+	Action   flee   { [](Entity const& e) { return e.distance * 2.f; } };
+	Action   attack { [](Entity const& e) { return e.health * .5f; } };
+	Action   wander { [](Entity const&)   { return 0.f; } };
+
+	auto tree = isHurt && flee || isClose && attack || wander;
+
+	std::span<Entity const> in{ entities };
+	std::vector<float> out(entities.size());
+
+	BENCHMARK("scalar")
+	{
+		for (size_t i{}; i < in.size(); ++i)
+			out[i] = tree(in[i]);
+		return out.back();
+	};
+
+	BENCHMARK("batch")
+	{
+		EvaluateBatch(tree, in, std::span{ out });
+		return out.back();
+	};
+
+	// Same tree, with decisions that also accept a whole batch at once
+	Decision isHurtBatch{ JL::Visitor{
+		[](Entity const& e) { return e.health < 30.f; },
+		[](std::span<Entity const> in, std::span<std::uint8_t> mask)
+		{
+			for (size_t i{}; i < in.size(); ++i)
+				mask[i] = in[i].health < 30.f;
+		}
+	} };
+
+	auto batchTree = isHurtBatch && flee || isClose && attack || wander;
+
+	BENCHMARK("batch with batch decisions")
+	{
+		EvaluateBatch(batchTree, in, std::span{ out });
+		return out.back();
+	};
+
+}
+
+#endif
@@ -0,0 +1,252 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace JL::action_tree
+{
+
+	// Tag of a blackboard entry, for entries that share a type:
+	//
+	//   struct Health : Entry<int> {};
+	//   struct Ammo   : Entry<int> {};
+	//
+	// Any other type is a tag for an entry of its own type.
+	template <typename T>
+	struct Entry
+	{
+		using entry_type = T;
+	};
+
+	// Data that the nodes of a tree share, one per tree instance. Every entry lives in one block at an offset that is
+	// known at compile time, entries that fit in a cache line never straddle two. Entries are laid out in the order
+	// they are listed, list the ones that are used together next to each other.
+	template <typename ... K>
+	class Blackboard;
+
+	// Node that reads entries of the blackboard it is called with, instead of taking them as arguments:
+	//
+	//   Decision isHurt{ Uses<Health>([](int& health) { return health < 30; }) };
+	//   isHurt(board);
+	//
+	// The entries come first, followed by the arguments after the board.
+	template <typename ... K, typename F>
+	auto /*Uses*/ Uses(F);
+
+	namespace impl
+	{
+
+		template <typename K, typename = void>
+		struct EntryType
+		{
+			using type = K;
+		};
+
+		template <typename K>
+		struct EntryType<K, std::void_t<typename K::entry_type>>
+		{
+			using type = typename K::entry_type;
+		};
+
+		template <typename K>
+		using entry_t = typename EntryType<K>::type;
+
+		constexpr size_t cache_line = 64;
+
+		// Offset of every entry, followed by the size of the block
+		template <typename ... T>
+		constexpr std::array<size_t, sizeof...(T) + 1> BoardLayout();
+
+		// Small blackboards are aligned to the power of two they fit in, so they do not straddle a cache line either
+		template <typename ... T>
+		constexpr size_t BoardAlignment();
+
+		template <typename K, typename ... Ks>
+		constexpr size_t BoardIndex();
+
+		template <typename F, typename ... K>
+		struct Uses
+		{
+			F function;
+
+			template <typename B, typename ... P>
+			auto operator () (B& board, P&& ... p)       -> decltype(function(board.template Get<K>()..., std::forward<P>(p)...));
+			template <typename B, typename ... P>
+			auto operator () (B& board, P&& ... p) const -> decltype(function(board.template Get<K>()..., std::forward<P>(p)...));
+		};
+
+	}
+
+	template <typename ... K>
+	class alignas(impl::BoardAlignment<impl::entry_t<K>...>()) Blackboard
+	{
+	public:
+
+		// Every entry value initialised
+		Blackboard();
+		~Blackboard();
+
+		Blackboard(Blackboard const&);
+		Blackboard(Blackboard&&) noexcept;
+		Blackboard& operator = (Blackboard const&);
+		Blackboard& operator = (Blackboard&&) noexcept;
+
+		template <typename T>
+		impl::entry_t<T>&       Get()       noexcept;
+		template <typename T>
+		impl::entry_t<T> const& Get() const noexcept;
+
+		// Where an entry is in the block
+		template <typename T>
+		static constexpr size_t Offset() noexcept { return layout[impl::BoardIndex<T, K...>()]; }
+
+	private:
+
+		static constexpr auto layout = impl::BoardLayout<impl::entry_t<K>...>();
+
+		std::byte block[layout.back() ? layout.back() : 1];
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		template <typename ... T>
+		constexpr std::array<size_t, sizeof...(T) + 1> BoardLayout()
+		{
+			static_assert(((alignof(T) <= cache_line) && ...), "Blackboard  Entries can not be aligned to more than a cache line.");
+
+			constexpr size_t sizes [sizeof...(T) + 1]{ sizeof (T)..., 0 };
+			constexpr size_t aligns[sizeof...(T) + 1]{ alignof(T)..., 1 };
+
+			std::array<size_t, sizeof...(T) + 1> offsets{};
+			size_t end{};
+			for (size_t i{}; i < sizeof...(T); ++i)
+			{
+				size_t offset = (end + aligns[i] - 1) / aligns[i] * aligns[i];
+				if (sizes[i] <= cache_line && offset / cache_line != (offset + sizes[i] - 1) / cache_line)
+					offset = (offset / cache_line + 1) * cache_line;
+				offsets[i] = offset;
+				end        = offset + sizes[i];
+			}
+			offsets[sizeof...(T)] = end;
+			return offsets;
+		}
+
+		template <typename ... T>
+		constexpr size_t BoardAlignment()
+		{
+			size_t alignment{ 1 };
+			while (alignment < cache_line && alignment < BoardLayout<T...>().back())
+				alignment *= 2;
+			return std::max({ alignment, alignof(T)... });
+		}
+
+		template <typename K, typename ... Ks>
+		constexpr size_t BoardIndex()
+		{
+			constexpr bool matches[sizeof...(Ks) + 1]{ std::is_same_v<K, Ks>..., false };
+			static_assert((size_t{} + ... + std::is_same_v<K, Ks>) == 1, "Blackboard  The entry is not on this blackboard, or is on it more than once.");
+
+			size_t index{};
+			while (!matches[index])
+				++index;
+			return index;
+		}
+
+		template <typename F, typename ... K>
+		template <typename B, typename ... P>
+		auto Uses<F, K...>::operator()(B& board, P&& ... p) -> decltype(function(board.template Get<K>()..., std::forward<P>(p)...))
+		{
+			return function(board.template Get<K>()..., std::forward<P>(p)...);
+		}
+
+		template <typename F, typename ... K>
+		template <typename B, typename ... P>
+		auto Uses<F, K...>::operator()(B& board, P&& ... p) const -> decltype(function(board.template Get<K>()..., std::forward<P>(p)...))
+		{
+			return function(board.template Get<K>()..., std::forward<P>(p)...);
+		}
+
+	}
+
+	template <typename ... K>
+	Blackboard<K...>::Blackboard()
+	{
+		(::new (block + Offset<K>()) impl::entry_t<K>{}, ...);
+	}
+
+	template <typename ... K>
+	Blackboard<K...>::~Blackboard()
+	{
+		(std::destroy_at(&Get<K>()), ...);
+	}
+
+	template <typename ... K>
+	Blackboard<K...>::Blackboard(Blackboard const& other)
+	{
+		(::new (block + Offset<K>()) impl::entry_t<K>(other.Get<K>()), ...);
+	}
+
+	template <typename ... K>
+	Blackboard<K...>::Blackboard(Blackboard&& other) noexcept
+	{
+		(::new (block + Offset<K>()) impl::entry_t<K>(std::move(other.Get<K>())), ...);
+	}
+
+	template <typename ... K>
+	Blackboard<K...>& Blackboard<K...>::operator=(Blackboard const& other)
+	{
+		((Get<K>() = other.Get<K>()), ...);
+		return *this;
+	}
+
+	template <typename ... K>
+	Blackboard<K...>& Blackboard<K...>::operator=(Blackboard&& other) noexcept
+	{
+		((Get<K>() = std::move(other.Get<K>())), ...);
+		return *this;
+	}
+
+	template <typename ... K>
+	template <typename T>
+	impl::entry_t<T>& Blackboard<K...>::Get() noexcept
+	{
+		return *std::launder(reinterpret_cast<impl::entry_t<T>*>(block + Offset<T>()));
+	}
+
+	template <typename ... K>
+	template <typename T>
+	impl::entry_t<T> const& Blackboard<K...>::Get() const noexcept
+	{
+		return *std::launder(reinterpret_cast<impl::entry_t<T> const*>(block + Offset<T>()));
+	}
+
+	template <typename ... K, typename F>
+	auto Uses(F function)
+	{
+		return impl::Uses<F, K...>{ std::move(function) };
+	}
+
+}
\ No newline at end of file
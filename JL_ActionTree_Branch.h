@@ -20,8 +20,10 @@ namespace JL::action_tree::impl
 		D decision;
 		A action;
 
-		TEMPLATE  /* Action */ operator || (Action<T>);
-		TEMPLATE2 /* Stack  */ operator || (Branch<T1, T2>&&);
+		TEMPLATE  /* Action */ operator || (Action<T>) const&;
+		TEMPLATE  /* Action */ operator || (Action<T>) &&;
+		TEMPLATE2 /* Stack  */ operator || (Branch<T1, T2>&&) const&;
+		TEMPLATE2 /* Stack  */ operator || (Branch<T1, T2>&&) &&;
 	};
 
 	template <typename ... B>
@@ -29,13 +31,44 @@ namespace JL::action_tree::impl
 	{
 		using std::tuple<B...>::tuple;
 
-		TEMPLATE  /* Action */ operator || (Action<T>);
-		TEMPLATE2 /* Stack  */ operator || (Branch<T1, T2>&&);
+		TEMPLATE  /* Action */ operator || (Action<T>) const&;
+		TEMPLATE  /* Action */ operator || (Action<T>) &&;
+		TEMPLATE2 /* Stack  */ operator || (Branch<T1, T2>&&) const&;
+		TEMPLATE2 /* Stack  */ operator || (Branch<T1, T2>&&) &&;
 
-		template<typename T, size_t ... I>
-		auto ReduceStack(Action<T>&, std::index_sequence<I...>);
+		template<typename T>
+		constexpr auto ReduceStack(Action<T>&);
 	};
 
+	// d1 && a1 || d2 && a2 || ... || a
+	template <typename A, typename ... B>
+	struct Cascade
+	{
+		std::tuple<B...> branches;
+		A                fallback;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	template <typename D, typename A, typename ... P>
+	struct Stateless<Branch<D, A>, P...> : std::conjunction<Stateless<D, P...>, Stateless<A, P...>> {};
+
+	template <typename A, typename ... B, typename ... P>
+	struct Stateless<Cascade<A, B...>, P...> : std::conjunction<Stateless<B, P...>..., Stateless<A, P...>> {};
+
+	// Result of a branch stack, built from the results of all its actions
+	//   all the same       T
+	//   T and void         Maybe<T>
+	//   otherwise          variant<A, B, ...>  duplicates removed, void as monostate
+	template <typename ... R>
+	struct StackResult;
+
+	template <typename ... R>
+	using StackResult_t = typename StackResult<R...>::type;
+
 }
 
 
@@ -47,83 +80,215 @@ namespace JL::action_tree::impl
 
 	template <typename _D, typename _A>
 	template <typename T>
-	auto Branch<_D, _A>::operator||(Action<T> action)
+	constexpr auto Branch<_D, _A>::operator||(Action<T> action) const&
 	{
-		auto f{
-			[a = std::move(*this), b = std::move(action)]
-			(auto&& ... p) mutable
-			{
-				using Ra = decltype(a.action(p...));
-				using Rb = decltype(b(p...));
-				bool const test = a.decision(p...);
-				if constexpr (std::is_same_v<Ra, Rb>)
-				{
-					return test ? a.action(p...) : b(p...);
-				}
-				else
-				if constexpr (std::is_void_v<Ra>)
-				{
-					using Maybe = impl::Maybe<Rb>;
-					return test ? (a.action(p...), Maybe{}) : Maybe{ b(p...) };
-				}
-				else
-				if constexpr (std::is_void_v<Rb>)
-				{
-					using Maybe = impl::Maybe<Ra>;
-					return test ? Maybe{ a.action(p...) } : (b(p...), Maybe{});
-				}
-				else
-				{
-					using Either = Either<Ra, Rb>;
-					if (a.decision(p...))
-						return Either{ a.action(p...) };
-					else
-						return Either{ b(p...) };
-				}
-			}
-		};
-		return Action<decltype(f)>{ std::move(f) };
+		return Branch<_D, _A>(*this) || std::move(action);
+	}
+
+	template <typename _D, typename _A>
+	template <typename T>
+	constexpr auto Branch<_D, _A>::operator||(Action<T> action) &&
+	{
+		return Stack<Branch<_D, _A>>{ std::move(*this) } || std::move(action);
+	}
+
+	template <typename _D, typename _A>
+	template <typename T1, typename T2>
+	constexpr auto Branch<_D, _A>::operator||(Branch<T1, T2>&& other) const&
+	{
+		return Branch<_D, _A>(*this) || std::move(other);
 	}
 
 	template <typename _D, typename _A>
 	template <typename T1, typename T2>
-	auto Branch<_D, _A>::operator||(Branch<T1, T2>&& other)
+	constexpr auto Branch<_D, _A>::operator||(Branch<T1, T2>&& other) &&
 	{
 		return Stack<Branch<_D, _A>, Branch<T1, T2>>{ std::move(*this), std::move(other) };
 	}
 
+	//------------------
+	//   StackResult
+
+	template <typename ... T>
+	struct TypeList {};
+
+	template <typename List, typename ... R>
+	struct Unique { using type = List; };
+
+	template <typename ... T, typename R, typename ... Rs>
+	struct Unique<TypeList<T...>, R, Rs...>
+		: std::conditional_t<
+			(std::is_same_v<T, R> || ...),
+			Unique<TypeList<T...>, Rs...>,
+			Unique<TypeList<T..., R>, Rs...>
+		>
+	{};
+
+	template <typename List>
+	struct StackResultOf;
+
+	template <typename R>
+	struct StackResultOf<TypeList<R>> { using type = R; };
+
+	template <typename R>
+	struct StackResultOf<TypeList<void, R>> { using type = Maybe<R>; };
+
+	template <typename R>
+	struct StackResultOf<TypeList<R, void>> { using type = Maybe<R>; };
+
+	template <typename ... R>
+	struct StackResultOf<TypeList<R...>>
+	{
+		using type = std::variant<std::conditional_t<std::is_void_v<R>, std::monostate, R>...>;
+	};
+
+	template <typename ... R>
+	struct StackResult : StackResultOf<typename Unique<TypeList<>, R...>::type> {};
+
+	template <typename T>
+	constexpr bool is_maybe_v = false;
+
+	template <typename T>
+	constexpr bool is_maybe_v<Maybe<T>> = true;
+
+	// Runs an action and puts its result directly in the slot of the stack result
+	template <typename R, typename A, typename ... P>
+	constexpr R RunInto(A& action, P&& ... p)
+	{
+		using Ra = decltype(action(std::forward<P>(p)...));
+		if constexpr (std::is_same_v<R, Ra>)			// T
+			return action(std::forward<P>(p)...);
+		else
+		if constexpr (std::is_void_v<Ra>)				// void
+		{
+			action(std::forward<P>(p)...);
+			if constexpr (is_maybe_v<R>)
+				return R{};
+			else
+				return R{ std::in_place_type<std::monostate> };
+		}
+		else
+		if constexpr (std::is_same_v<R, Maybe<Ra>>)		// Maybe<T>
+			return R{ std::in_place, action(std::forward<P>(p)...) };
+		else											// variant<..., T, ...>
+			return R{ std::in_place_type<Ra>, action(std::forward<P>(p)...) };
+	}
+
+	// Same as RunInto, for a result that has already been computed
+	template <typename R, typename Ra, typename V>
+	constexpr R WrapResult(V&& value)
+	{
+		if constexpr (std::is_same_v<R, Ra>)
+			return std::forward<V>(value);
+		else
+		if constexpr (std::is_same_v<R, Maybe<Ra>>)
+			return R{ std::in_place, std::forward<V>(value) };
+		else
+			return R{ std::in_place_type<Ra>, std::forward<V>(value) };
+	}
+
+	template <typename R>
+	constexpr R EmptyResult()
+	{
+		if constexpr (is_maybe_v<R>)
+			return R{};
+		else
+			return R{ std::in_place_type<std::monostate> };
+	}
+
+	// First branch whose decision holds, or the last action
+	template <typename R, size_t I, typename B, typename A, typename ... P>
+	constexpr R RunStack(B& branches, A& last, P&& ... p)
+	{
+		if constexpr (I == std::tuple_size_v<B>)
+			return RunInto<R>(last, std::forward<P>(p)...);
+		else
+		{
+			auto&         branch = std::get<I>(branches);
+			constexpr int hint   = likelihood_v<std::remove_const_t<decltype(branch.decision)>>;
+			if constexpr (hint != 0)
+				return RunHinted<hint>(
+					branch.decision(p...),
+					[&]() -> R { return RunInto<R>(branch.action, std::forward<P>(p)...); },
+					[&]() -> R { return RunStack<R, I + 1>(branches, last, std::forward<P>(p)...); }
+				);
+			else
+			if (branch.decision(p...))
+				return RunInto<R>(branch.action, std::forward<P>(p)...);
+			else
+				return RunStack<R, I + 1>(branches, last, std::forward<P>(p)...);
+		}
+	}
+
+	//--------------
+	//   Cascade
+
+	template <typename A, typename ... B>
+	template <typename ... P>
+	constexpr auto Cascade<A, B...>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(std::declval<B&>().decision(p...))..., decltype(std::declval<B&>().action(p...))..., decltype(fallback(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+		{
+			using R = StackResult_t<decltype(std::declval<B&>().action(p...))..., decltype(fallback(p...))>;
+			return RunStack<R, 0>(branches, fallback, std::forward<P>(p)...);
+		}
+	}
+
+	template <typename A, typename ... B>
+	template <typename ... P>
+	constexpr auto Cascade<A, B...>::operator()(P&& ... p) const
+	{
+		RequireStateless<P...>(*this);
+		using R = StackResult_t<decltype(std::declval<B const&>().action(p...))..., decltype(fallback(p...))>;
+		return RunStack<R, 0>(branches, fallback, std::forward<P>(p)...);
+	}
+
 	//------------
 	//   Stack
 
 	template <typename ... _T>
-	template <typename A, size_t ... I>
-	auto Stack<_T...>::ReduceStack(Action<A>& action, std::index_sequence<I...>)
+	template <typename A>
+	constexpr auto Stack<_T...>::ReduceStack(Action<A>& action)
 	{
-		//    <-----------------o
-		//  (1 || (... ( N || action)))
-		return (std::move(std::get<I>(*this)) || ... || std::move(action));
+		//  1 || 2 || ... || N || action
+		using Cascade = Cascade<Action<A>, _T...>;
+		return Action<Cascade>{ Cascade{ std::tuple<_T...>{ std::move(*this) }, std::move(action) } };
 	}
 
 	template <typename ... _T>
 	template <typename T>
-	auto Stack<_T...>::operator||(Action<T> action)
+	constexpr auto Stack<_T...>::operator||(Action<T> action) const&
 	{
-		return ReduceStack(
-			action,
-			std::index_sequence_for<_T...>{}
-		);
+		return Stack<_T...>(*this) || std::move(action);
+	}
+
+	template <typename ... _T>
+	template <typename T>
+	constexpr auto Stack<_T...>::operator||(Action<T> action) &&
+	{
+		return ReduceStack(action);
 	}
 
 	template <typename ... _T>
 	template <typename T1, typename T2>
-	auto Stack<_T...>::operator||(Branch<T1, T2>&& next)
-	{
-		return Stack<_T..., Branch<T1, T2>>{
-			std::tuple_cat(
-				std::tuple<_T...>{ std::move(*this) },
-				std::tuple{ std::move(next) }
-			)
-		};
+	constexpr auto Stack<_T...>::operator||(Branch<T1, T2>&& next) const&
+	{
+		return Stack<_T...>(*this) || std::move(next);
+	}
+
+	template <typename ... _T>
+	template <typename T1, typename T2>
+	constexpr auto Stack<_T...>::operator||(Branch<T1, T2>&& next) &&
+	{
+		return std::apply(
+			[&next](auto&& ... branches)
+			{
+				return Stack<_T..., Branch<T1, T2>>{ std::move(branches)..., std::move(next) };
+			},
+			static_cast<std::tuple<_T...>&&>(*this)
+		);
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+// A deep tree, in one piece or split over translation units by firewalls.
+// Built once per part by JL_ActionTree_CompileBench.sh, which compares build time, object size and symbols.
+//   DEPTH   layers of  d && a || <next layer>,  three nodes each
+//   PARTS   translation units the layers are split over, 1 is the whole tree in one
+//   PART    this translation unit, part 0 also has main
+
+#include "JL_ActionTree.h"
+using namespace JL::action_tree;
+
+#include <cstdio>
+#include <type_traits>
+
+#ifndef DEPTH
+#define DEPTH 64
+#endif
+
+#ifndef PARTS
+#define PARTS 1
+#endif
+
+#ifndef PART
+#define PART 0
+#endif
+
+constexpr int first = DEPTH *  PART      / PARTS;
+constexpr int last  = DEPTH * (PART + 1) / PARTS;
+
+template <int Part>
+using PartIndex = std::integral_constant<int, Part>;
+
+// Defined by the translation unit of that part
+ActionFirewall<int(int)> Subtree(PartIndex<PART>);
+ActionFirewall<int(int)> Subtree(PartIndex<PART + 1>);
+
+namespace
+{
+
+// Internal, every part has its own Layers<last>
+template <int L>
+auto Layers()
+{
+	if constexpr (L < last)
+	{
+		Decision test{ [](int i) { return i % (L + 2) == 0; } };
+		Action   act { [](int i) { return i * (L + 1); } };
+		return (std::move(test) && std::move(act)) || Layers<L + 1>();
+	}
+	else
+	if constexpr (PART + 1 < PARTS)
+		return Subtree(PartIndex<PART + 1>{});
+	else
+		return Action{ [](int i) { return -i; } };
+}
+
+}
+
+ActionFirewall<int(int)> Subtree(PartIndex<PART>)
+{
+	static auto tree = Layers<first>();
+	return Firewall<int(int)>(tree);
+}
+
+#if PART == 0
+
+int main()
+{
+	auto tree = Subtree(PartIndex<0>{});
+
+	long long sum{};
+	for (int i{}; i < 100000; ++i)
+		sum += tree(i);
+
+	std::printf("%lld\n", sum);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Build time, object size and symbols of a deep tree (JL_ActionTree_CompileBench.cpp),
+# in one piece and split over translation units by firewalls.
+#
+#   ./JL_ActionTree_CompileBench.sh [depth [parts ...]]     defaults: 64 layers (192 nodes), 1 4 16 parts
+#
+# CXX and CXXFLAGS are taken from the environment.
+#   build ms     all parts, one after the other
+#   slowest ms   the largest part, what a change to one part costs
+#   functions    functions emitted, template instantiations that were not inlined away
+#   longest      length of the longest symbol
+
+set -e
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2}
+DEPTH=${1:-64}
+[ $# -gt 0 ] && shift
+PARTS=${*:-1 4 16}
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+now() { date +%s%N; }
+
+printf '%-6s %10s %11s %11s %10s %10s %8s  %s\n' parts "build ms" "slowest ms" "objects B" "binary B" functions longest result
+for parts in $PARTS; do
+	total=0
+	slowest=0
+	part=0
+	while [ "$part" -lt "$parts" ]; do
+		begin=$(now)
+		$CXX $CXXFLAGS -DDEPTH="$DEPTH" -DPARTS="$parts" -DPART="$part" -c JL_ActionTree_CompileBench.cpp -o "$OUT/part$part.o"
+		ms=$(( ($(now) - begin) / 1000000 ))
+		total=$((total + ms))
+		[ "$ms" -gt "$slowest" ] && slowest=$ms
+		part=$((part + 1))
+	done
+
+	$CXX $CXXFLAGS "$OUT"/part*.o -o "$OUT/tree"
+
+	objects=$(cat "$OUT"/part*.o | wc -c)
+	binary=$(wc -c < "$OUT/tree")
+	functions=$(nm "$OUT"/part*.o | grep -c ' [TtWw] ' || true)
+	longest=$(nm "$OUT"/part*.o | awk '{ if (length($NF) > n) n = length($NF) } END { print n + 0 }')
+	result=$("$OUT/tree")
+
+	printf '%-6s %10s %11s %11s %10s %10s %8s  %s\n' "$parts" "$total" "$slowest" "$objects" "$binary" "$functions" "$longest" "$result"
+	rm -f "$OUT"/part*.o
+done
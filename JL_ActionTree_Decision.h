@@ -12,24 +12,35 @@
 #include "JL_ActionTree_Action.h"
 #include "JL_ActionTree_Branch.h"
 
+#include <cstdint>
+
 namespace JL::action_tree
 {
 
 	template <typename F>
 	struct Decision : impl::Functor<F>
 	{
-		auto      /*Decision*/ operator ! ();
+		constexpr auto /*Decision*/ operator ! () const&;
+		constexpr auto /*Decision*/ operator ! () &&;
 
-		TEMPLATE  /*Decision*/ operator |  (Decision<T>);
-		TEMPLATE  /*Decision*/ operator || (Decision<T>);
-		TEMPLATE  /*Decision*/ operator &  (Decision<T>);
-		TEMPLATE  /*Decision*/ operator && (Decision<T>);
+		TEMPLATE  /*Decision*/ operator |  (Decision<T>) const&;
+		TEMPLATE  /*Decision*/ operator |  (Decision<T>) &&;
+		TEMPLATE  /*Decision*/ operator || (Decision<T>) const&;
+		TEMPLATE  /*Decision*/ operator || (Decision<T>) &&;
+		TEMPLATE  /*Decision*/ operator &  (Decision<T>) const&;
+		TEMPLATE  /*Decision*/ operator &  (Decision<T>) &&;
+		TEMPLATE  /*Decision*/ operator && (Decision<T>) const&;
+		TEMPLATE  /*Decision*/ operator && (Decision<T>) &&;
 
-		TEMPLATE  /* Action */ operator +  (Action<T>);
-		TEMPLATE  /* Action */ operator -  (Action<T>);
-		TEMPLATE  /* Action */ operator &  (Action<T>);
+		TEMPLATE  /* Action */ operator +  (Action<T>) const&;
+		TEMPLATE  /* Action */ operator +  (Action<T>) &&;
+		TEMPLATE  /* Action */ operator -  (Action<T>) const&;
+		TEMPLATE  /* Action */ operator -  (Action<T>) &&;
+		TEMPLATE  /* Action */ operator &  (Action<T>) const&;
+		TEMPLATE  /* Action */ operator &  (Action<T>) &&;
 
-		TEMPLATE  /* Branch */ operator && (Action<T>);
+		TEMPLATE  /* Branch */ operator && (Action<T>) const&;
+		TEMPLATE  /* Branch */ operator && (Action<T>) &&;
 	};
 
 	template <typename T>
@@ -37,133 +48,371 @@ namespace JL::action_tree
 
 }
 
+namespace JL::action_tree::impl
+{
+
+	// !d
+	template <typename D>
+	struct Not
+	{
+		D decision;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	// a | b
+	template <typename A, typename B>
+	struct Or
+	{
+		A a;
+		B b;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	// a & b
+	template <typename A, typename B>
+	struct And
+	{
+		A a;
+		B b;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	// d + a, d - a
+	template <typename D, typename A, bool Rising>
+	struct Edge
+	{
+		static constexpr uint32_t unshared = ~uint32_t{};
+
+		D        decision;
+		A        action;
+		bool     on   = !Rising;
+		uint32_t slot = unshared;	// column of its state when it is part of a shared tree
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+
+		// The last result, of the running instance when the tree is shared
+		constexpr bool& State() noexcept;
+	};
+
+	// d & a
+	template <typename D, typename A>
+	struct Conditional
+	{
+		D decision;
+		A action;
+
+		template <typename ... P>
+		constexpr auto operator () (P&& ...);
+		template <typename ... P>
+		constexpr auto operator () (P&& ...) const;
+	};
+
+	template <typename F, typename ... P>
+	struct Stateless<Decision<F>, P...> : Stateless<F, P...> {};
+
+	template <typename D, typename ... P>
+	struct Stateless<Not<D>, P...> : Stateless<D, P...> {};
+
+	template <typename A, typename B, typename ... P>
+	struct Stateless<Or<A, B>, P...> : std::conjunction<Stateless<A, P...>, Stateless<B, P...>> {};
+
+	template <typename A, typename B, typename ... P>
+	struct Stateless<And<A, B>, P...> : std::conjunction<Stateless<A, P...>, Stateless<B, P...>> {};
+
+	// Remembers the last result
+	template <typename D, typename A, bool Rising, typename ... P>
+	struct Stateless<Edge<D, A, Rising>, P...> : std::false_type {};
+
+	template <typename D, typename A, typename ... P>
+	struct Stateless<Conditional<D, A>, P...> : std::conjunction<Stateless<D, P...>, Stateless<A, P...>> {};
+
+}
+
 
 
 // Implementation
 
+namespace JL::action_tree::impl
+{
+
+	template <typename D>
+	template <typename ... P>
+	constexpr auto Not<D>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(decision(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+			return !decision(std::forward<P>(p)...);
+	}
+
+	template <typename D>
+	template <typename ... P>
+	constexpr auto Not<D>::operator()(P&& ... p) const
+	{
+		RequireStateless<P...>(*this);
+		return !decision(std::forward<P>(p)...);
+	}
+
+	template <typename A, typename B>
+	template <typename ... P>
+	constexpr auto Or<A, B>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(a(p...)), decltype(b(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+			return a(p...) || b(std::forward<P>(p)...);
+	}
+
+	template <typename A, typename B>
+	template <typename ... P>
+	constexpr auto Or<A, B>::operator()(P&& ... p) const
+	{
+		RequireStateless<P...>(*this);
+		return a(p...) || b(std::forward<P>(p)...);
+	}
+
+	template <typename A, typename B>
+	template <typename ... P>
+	constexpr auto And<A, B>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(a(p...)), decltype(b(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+			return a(p...) && b(std::forward<P>(p)...);
+	}
+
+	template <typename A, typename B>
+	template <typename ... P>
+	constexpr auto And<A, B>::operator()(P&& ... p) const
+	{
+		RequireStateless<P...>(*this);
+		return a(p...) && b(std::forward<P>(p)...);
+	}
+
+	template <typename D, typename A, bool Rising>
+	template <typename ... P>
+	constexpr auto Edge<D, A, Rising>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(decision(p...)), decltype(action(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+		{
+			bool const test = decision(p...);
+			bool&      last = State();
+			if (test != last && test == Rising)
+				(void)action(std::forward<P>(p)...);
+			return last = test;
+		}
+	}
+
+	template <typename D, typename A, bool Rising>
+	constexpr bool& Edge<D, A, Rising>::State() noexcept
+	{
+#ifdef __cpp_lib_is_constant_evaluated
+		// The instance first: it is thread local, so compilers load it once per loop, and trees that are not
+		// shared skip the slot. The slot is a member that the actions may change as far as they know.
+		if (!std::is_constant_evaluated())
+		{
+			if (auto instance = InstanceSlots::current)
+				if (slot != unshared)
+					return instance->states[slot * instance->stride];
+			return on;
+		}
+#endif
+		if (slot != unshared)
+			if (auto instance = InstanceSlots::current)
+				return instance->states[slot * instance->stride];
+		return on;
+	}
+
+	// d & a, Maybe<R> or void
+	template <typename D, typename A, typename ... P>
+	constexpr auto RunConditional(D& decision, A& action, P&& ... p)
+	{
+		using R = decltype(action(std::forward<P>(p)...));
+		constexpr int hint = likelihood_v<std::remove_const_t<D>>;
+		if constexpr (std::is_void_v<R>)
+		{
+			if constexpr (hint != 0)
+				RunHinted<hint>(decision(p...), [&] { action(std::forward<P>(p)...); }, [] {});
+			else
+			if (decision(p...))
+				action(std::forward<P>(p)...);
+			return;
+		}
+		else
+		{
+			if constexpr (hint != 0)
+				return RunHinted<hint>(decision(p...), [&] { return Maybe<R>{ action(std::forward<P>(p)...) }; }, [] { return Maybe<R>{}; });
+			else
+				return decision(p...) ? Maybe<R>{ action(std::forward<P>(p)...) } : Maybe<R>{};
+		}
+	}
+
+	template <typename D, typename A>
+	template <typename ... P>
+	constexpr auto Conditional<D, A>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(decision(p...)), decltype(action(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+			return RunConditional(decision, action, std::forward<P>(p)...);
+	}
+
+	template <typename D, typename A>
+	template <typename ... P>
+	constexpr auto Conditional<D, A>::operator()(P&& ... p) const
+	{
+		RequireStateless<P...>(*this);
+		return RunConditional(decision, action, std::forward<P>(p)...);
+	}
+
+}
+
 namespace JL::action_tree
 {
 
 	template <typename _T>
-	auto Decision<_T>::operator!()
+	constexpr auto Decision<_T>::operator!() const&
 	{
-		auto f{
-			[d = *this]
-			(auto&& ... p) mutable
-			{
-				return !d(p...);
-			}
-		};
-		return Decision<decltype(f)>{ std::move(f) };
+		return !Decision<_T>(*this);
+	}
+
+	template <typename _T>
+	constexpr auto Decision<_T>::operator!() &&
+	{
+		using Not = impl::Not<Decision<_T>>;
+		return Decision<Not>{ Not{ std::move(*this) } };
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator|(Decision<T> other) const&
+	{
+		return Decision<_T>(*this) | std::move(other);
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator|(Decision<T> other)
+	constexpr auto Decision<_T>::operator|(Decision<T> other) &&
 	{
-		auto f{
-			[a = *this, b = std::move(other)]
-			(auto&& ... p) mutable
-			{
-				return a(p...) || b(p...);
-			}
-		};
-		return Decision<decltype(f)>{ std::move(f) };
+		using Or = impl::Or<Decision<_T>, Decision<T>>;
+		return Decision<Or>{ Or{ std::move(*this), std::move(other) } };
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator||(Decision<T> other)
+	constexpr auto Decision<_T>::operator||(Decision<T> other) const&
 	{
 		return *this | std::move(other);
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator&(Decision<T> other)
+	constexpr auto Decision<_T>::operator||(Decision<T> other) &&
 	{
-		auto f{
-			[a = *this, b = std::move(other)]
-			(auto&& ... p) mutable
-			{
-				return a(p...) && b(p...);
-			}
-		};
-		return Decision<decltype(f)>{ std::move(f) };
+		return std::move(*this) | std::move(other);
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::
-		operator&&(Decision<T> other)
+	constexpr auto Decision<_T>::operator&(Decision<T> other) const&
+	{
+		return Decision<_T>(*this) & std::move(other);
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator&(Decision<T> other) &&
+	{
+		using And = impl::And<Decision<_T>, Decision<T>>;
+		return Decision<And>{ And{ std::move(*this), std::move(other) } };
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator&&(Decision<T> other) const&
 	{
 		return *this & std::move(other);
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator+(Action<T> other)
+	constexpr auto Decision<_T>::operator&&(Decision<T> other) &&
+	{
+		return std::move(*this) & std::move(other);
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator+(Action<T> other) const&
+	{
+		return Decision<_T>(*this) + std::move(other);
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator+(Action<T> other) &&
+	{
+		using Edge = impl::Edge<Decision<_T>, Action<T>, true>;
+		return Decision<Edge>{ Edge{ std::move(*this), std::move(other) } };
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator-(Action<T> other) const&
+	{
+		return Decision<_T>(*this) - std::move(other);
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator-(Action<T> other) &&
+	{
+		using Edge = impl::Edge<Decision<_T>, Action<T>, false>;
+		return Decision<Edge>{ Edge{ std::move(*this), std::move(other) } };
+	}
+
+	template <typename _T>
+	template <typename T>
+	constexpr auto Decision<_T>::operator&(Action<T> action) const&
 	{
-		auto f{
-			[d = *this, a = std::move(other), on = false]
-			(auto&& ... p) mutable
-			{
-				bool const test = d(p...);
-				if (!on && test)
-					(void)a(p...);
-				return on = test;
-			}
-		};
-		return Decision<decltype(f)>{ std::move(f) };
+		return Decision<_T>(*this) & std::move(action);
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator-(Action<T> other)
+	constexpr auto Decision<_T>::operator&(Action<T> action) &&
 	{
-		auto f{
-			[d = *this, a = std::move(other), on = true]
-			(auto&& ... p) mutable
-			{
-				bool const test = d(p...);
-				if (on && !test)
-					(void)a(p...);
-				return on = test;
-			}
-		};
-		return Decision<decltype(f)>{ std::move(f) };
+		using Conditional = impl::Conditional<Decision<_T>, Action<T>>;
+		return Action<Conditional>{ Conditional{ std::move(*this), std::move(action) } };
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator&(Action<T> action)
+	constexpr auto Decision<_T>::operator&&(Action<T> action) const&
 	{
-		auto f{
-			[d = *this, a = std::move(action)]
-			(auto&& ... p) mutable
-			{
-				using R = decltype(a(p...));
-				if constexpr (std::is_void_v<R>)
-				{
-					if (d(p...))
-						a(p...);
-					return;
-				}
-				else
-				{
-					using Maybe = impl::Maybe<R>;
-					return d(p...) ? Maybe{ a(p...) } : Maybe{};
-				}
-			}
-		};
-		return Action<decltype(f)>{ std::move(f) };
+		return Decision<_T>(*this) && std::move(action);
 	}
 
 	template <typename _T>
 	template <typename T>
-	auto Decision<_T>::operator&&(Action<T> action)
+	constexpr auto Decision<_T>::operator&&(Action<T> action) &&
 	{
-		return impl::Branch<Decision<_T>, Action<T>>{ *this, std::move(action) };
+		return impl::Branch<Decision<_T>, Action<T>>{ std::move(*this), std::move(action) };
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+
+#include <functional>
+#include <utility>
+
+namespace JL::action_tree
+{
+
+	// Boundary in a tree: the subtree is called through a function pointer, so none of its types end up in the
+	// tree around it. Declare the subtree as a function in a header and build it in a translation unit of its own:
+	//
+	//   ActionFirewall<int(Entity&)> Combat();           // combat.h
+	//
+	//   ActionFirewall<int(Entity&)> Combat()            // combat.cpp
+	//   {
+	//       static auto tree = canSee && attack || chase;
+	//       return Firewall<int(Entity&)>(tree);
+	//   }
+	//
+	// The firewall refers to the subtree, which must outlive it. It is two pointers and never allocates.
+	template <typename S, typename T>
+	auto /* Action */ Firewall(Action<T>&);
+
+	// Same for a decision, S is bool(P...)
+	template <typename S, typename T>
+	auto /*Decision*/ Firewall(Decision<T>&);
+
+	// The subtree of a firewall is not part of the tree type, so a firewall counts as keeping state.
+	// A stateless firewall only takes a subtree that keeps none and calls it through a const reference,
+	// the tree around it may then be stateless too.
+	template <typename S, typename T>
+	auto /* Action */ StatelessFirewall(Action<T> const&);
+
+	template <typename S, typename T>
+	auto /*Decision*/ StatelessFirewall(Decision<T> const&);
+
+	template <typename S, typename T>
+	void StatelessFirewall(Action<T> const&&) = delete;
+
+	template <typename S, typename T>
+	void StatelessFirewall(Decision<T> const&&) = delete;
+
+	namespace impl
+	{
+
+		template <typename, bool Const = false>
+		struct Firewall {};
+
+		template <typename R, typename ... P, bool Const>
+		struct Firewall<R(P...), Const>
+		{
+			void* node{};
+			R   (*call)(void*, P&& ...){};
+
+			R operator () (P ...) const;
+
+			explicit operator bool () const noexcept { return call != nullptr; }
+		};
+
+		template <typename R, typename ... P, typename ... Q>
+		struct Stateless<Firewall<R(P...), false>, Q...> : std::false_type {};
+
+	}
+
+	template <typename S>
+	using ActionFirewall   = Action  <impl::Firewall<S>>;
+
+	template <typename S>
+	using DecisionFirewall = Decision<impl::Firewall<S>>;
+
+	template <typename S>
+	using StatelessActionFirewall   = Action  <impl::Firewall<S, true>>;
+
+	template <typename S>
+	using StatelessDecisionFirewall = Decision<impl::Firewall<S, true>>;
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		template <typename R, typename ... P, bool Const>
+		R Firewall<R(P...), Const>::operator()(P ... p) const
+		{
+			if (!call)
+				throw std::bad_function_call{};
+			return call(node, std::forward<P>(p)...);
+		}
+
+		// The only code that knows the type of the subtree, instantiated where the firewall is made
+		template <typename N, typename R, typename ... P>
+		R FirewallCall(void* node, P&& ... p)
+		{
+			if constexpr (std::is_void_v<R>)
+				(*static_cast<N*>(node))(std::forward<P>(p)...);
+			else
+				return (*static_cast<N*>(node))(std::forward<P>(p)...);
+		}
+
+		// N is const for a stateless firewall
+		template <typename N, typename R, typename ... P>
+		Firewall<R(P...), std::is_const_v<N>> MakeFirewall(N& node, R(*)(P...))
+		{
+			using Result = decltype(node(std::declval<P>()...));
+			static_assert(std::is_void_v<R> || std::is_convertible_v<Result, R>, "Firewall  The subtree does not return the type of the signature.");
+			static_assert(!std::is_const_v<N> || Stateless<std::remove_const_t<N>, P...>::value, "StatelessFirewall  The subtree keeps state, use Firewall.");
+			return { const_cast<void*>(static_cast<void const*>(&node)), &FirewallCall<N, R, P...> };
+		}
+
+	}
+
+	template <typename S, typename T>
+	auto Firewall(Action<T>& action)
+	{
+		return ActionFirewall<S>{ impl::MakeFirewall(action, static_cast<S*>(nullptr)) };
+	}
+
+	template <typename S, typename T>
+	auto Firewall(Decision<T>& decision)
+	{
+		static_assert(std::is_same_v<typename std::function<S>::result_type, bool>, "Firewall(Decision)  The signature must return bool.");
+		return DecisionFirewall<S>{ impl::MakeFirewall(decision, static_cast<S*>(nullptr)) };
+	}
+
+	template <typename S, typename T>
+	auto StatelessFirewall(Action<T> const& action)
+	{
+		return StatelessActionFirewall<S>{ impl::MakeFirewall(action, static_cast<S*>(nullptr)) };
+	}
+
+	template <typename S, typename T>
+	auto StatelessFirewall(Decision<T> const& decision)
+	{
+		static_assert(std::is_same_v<typename std::function<S>::result_type, bool>, "StatelessFirewall(Decision)  The signature must return bool.");
+		return StatelessDecisionFirewall<S>{ impl::MakeFirewall(decision, static_cast<S*>(nullptr)) };
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+
+#include <array>
+
+// Helpers that only run while compiling, where the compiler supports it
+#ifdef __cpp_consteval
+#define JL_ACTION_TREE_CONSTEVAL consteval
+#else
+#define JL_ACTION_TREE_CONSTEVAL constexpr
+#endif
+
+namespace JL::action_tree
+{
+
+	// Result of a tree for the given arguments, computed while compiling. The nodes of a tree that is built from
+	// constexpr lambdas can all be used in constant expressions:
+	//
+	//   constexpr auto limit = Fold(isDebug && debugLimit || releaseLimit, config);
+	//
+	template <typename T, typename ... P>
+	JL_ACTION_TREE_CONSTEVAL auto Fold(T tree, P ... p);
+
+	// Results of a tree for the keys 0, 1, ..., N-1, a table to look up in place of running the tree:
+	//
+	//   static constexpr auto price = Tabulate<256>(isRare && rarePrice || basePrice);
+	//   price[item];
+	//
+	// Every key runs on a fresh copy of the tree, after being converted to K.
+	template <size_t N, typename K = size_t, typename T>
+	JL_ACTION_TREE_CONSTEVAL auto Tabulate(T tree);
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	template <typename T, typename ... P>
+	JL_ACTION_TREE_CONSTEVAL auto Fold(T tree, P ... p)
+	{
+		static_assert(!std::is_void_v<decltype(tree(p...))>, "Fold(Tree, ...)  The tree has no result to fold.");
+		return tree(p...);
+	}
+
+	template <size_t N, typename K, typename T>
+	JL_ACTION_TREE_CONSTEVAL auto Tabulate(T tree)
+	{
+		using R = decltype(tree(K{}));
+		static_assert(!std::is_void_v<R>, "Tabulate<N>(Tree)  The tree has no result to put in the table.");
+
+		std::array<R, N> table{};
+		for (size_t key{}; key < N; ++key)
+		{
+			T fresh = tree;
+			table[key] = fresh(static_cast<K>(key));
+		}
+		return table;
+	}
+
+}
\ No newline at end of file
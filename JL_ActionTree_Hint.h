@@ -0,0 +1,112 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+
+namespace JL::action_tree
+{
+
+	// Tells the compiler which way a decision usually goes, where it picks between actions:
+	//
+	//   Unlikely(isBroken) && repair || Likely(isIdle) && wander || fight
+	//   Unlikely(isBroken) & repair
+	//
+	// The branch is marked [[likely]] or [[unlikely]] (C++20), and the side that is rarely taken is called out of
+	// line: the action of an unlikely decision, or everything after a likely one. Elsewhere the decision runs as it is.
+	template <typename T>
+	constexpr auto /*Decision*/ Likely(Decision<T>);
+
+	template <typename T>
+	constexpr auto /*Decision*/ Unlikely(Decision<T>);
+
+	// Likely for 1, Unlikely for -1, the decision as it is for 0. The value can come from ProfileHints.
+	template <int L, typename T>
+	constexpr auto /*Decision*/ Hint(Decision<T>);
+
+	namespace impl
+	{
+
+		template <typename D, int L>
+		struct Hinted
+		{
+			D decision;
+
+			template <typename ... P>
+			constexpr decltype(auto) operator () (P&& ...);
+			template <typename ... P>
+			constexpr decltype(auto) operator () (P&& ...) const;
+		};
+
+		template <typename D, int L>
+		constexpr int likelihood_v<Decision<Hinted<D, L>>> = L;
+
+		template <typename D, int L, typename ... P>
+		struct Stateless<Hinted<D, L>, P...> : Stateless<D, P...> {};
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		template <typename D, int L>
+		template <typename ... P>
+		constexpr decltype(auto) Hinted<D, L>::operator()(P&& ... p)
+		{
+			return decision(std::forward<P>(p)...);
+		}
+
+		template <typename D, int L>
+		template <typename ... P>
+		constexpr decltype(auto) Hinted<D, L>::operator()(P&& ... p) const
+		{
+			RequireStateless<P...>(*this);
+			return decision(std::forward<P>(p)...);
+		}
+
+	}
+
+	template <typename T>
+	constexpr auto Likely(Decision<T> decision)
+	{
+		return Hint<1>(std::move(decision));
+	}
+
+	template <typename T>
+	constexpr auto Unlikely(Decision<T> decision)
+	{
+		return Hint<-1>(std::move(decision));
+	}
+
+	template <int L, typename T>
+	constexpr auto Hint(Decision<T> decision)
+	{
+		static_assert(L >= -1 && L <= 1, "Hint<L>(Decision)  L must be 1 (likely), -1 (unlikely) or 0.");
+		if constexpr (L == 0)
+			return decision;
+		else
+		{
+			using Hinted = impl::Hinted<Decision<T>, L>;
+			return Decision<Hinted>{ Hinted{ std::move(decision) } };
+		}
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,271 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace JL::action_tree
+{
+
+	// Subtree that can be replaced while other threads are calling it:
+	//
+	//   HotSwap<int(Entity&)> combat{ canSee && attack || chase };
+	//   auto ai = isAlive && Live(combat) || idle;          // called by the workers
+	//   combat.Swap(canSee && flee || hide);                // called by any thread, at any time
+	//
+	// Calls take no lock and never allocate, every call runs the subtree that was live when it started. Swap makes
+	// the new subtree live at once, then waits until the calls that may still run the old one have returned before
+	// freeing it. Swaps wait for each other, a subtree must not swap the hot swap that it is called from.
+	template <typename S>
+	class HotSwap;
+
+	// Node that calls the live subtree of a hot swap, which must outlive it. A decision for bool(P...), an action otherwise.
+	template <typename S>
+	auto /* Action */ Live(HotSwap<S>&);
+
+	namespace impl
+	{
+
+		// A subtree that has been made live, freed by the hot swap that owns it
+		template <typename R, typename ... P>
+		struct SwapVersion
+		{
+			R   (*call   )(SwapVersion*, P&& ...);
+			void(*destroy)(SwapVersion*);
+		};
+
+		template <typename N, typename R, typename ... P>
+		struct SwapNode : SwapVersion<R, P...>
+		{
+			N node;
+
+			static R    Call   (SwapVersion<R, P...>*, P&& ...);
+			static void Destroy(SwapVersion<R, P...>*);
+		};
+
+		// Calls in flight, by the parity of the epoch they started in. Spread over shards by thread,
+		// so callers on different threads do not write to the same cache line.
+		struct alignas(64) SwapReaders
+		{
+			std::atomic<uint32_t> count[2]{};
+		};
+
+		constexpr size_t swap_shards = 16;
+
+		// Shard of the calling thread
+		size_t SwapShard() noexcept;
+
+		template <typename S>
+		struct LiveNode {};
+
+		template <typename R, typename ... P>
+		struct LiveNode<R(P...)>
+		{
+			HotSwap<R(P...)>* swap;
+
+			R operator () (P ...) const;
+		};
+
+		// The live subtree is not part of the type, it may keep state
+		template <typename S, typename ... P>
+		struct Stateless<LiveNode<S>, P...> : std::false_type {};
+
+	}
+
+	template <typename R, typename ... P>
+	class HotSwap<R(P...)>
+	{
+	public:
+
+		template <typename T>
+		explicit HotSwap(Action<T>);
+		template <typename T>
+		explicit HotSwap(Decision<T>);
+
+		// No call may be in flight
+		~HotSwap();
+
+		HotSwap(HotSwap const&) = delete;
+		HotSwap& operator = (HotSwap const&) = delete;
+
+		// Makes the subtree live, returns once no call runs the subtree it replaces, which is then freed
+		template <typename T>
+		void Swap(Action<T>);
+		template <typename T>
+		void Swap(Decision<T>);
+
+		// Runs the live subtree
+		R operator () (P ...) const;
+
+	private:
+
+		using Version = impl::SwapVersion<R, P...>;
+
+		template <typename N>
+		static Version* MakeVersion(N&&);
+
+		void Replace(Version*);
+
+		std::atomic<Version*>         live;
+		mutable std::atomic<uint64_t> epoch{};
+		mutable impl::SwapReaders     readers[impl::swap_shards];
+		std::mutex                    swapping;
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		template <typename N, typename R, typename ... P>
+		R SwapNode<N, R, P...>::Call(SwapVersion<R, P...>* version, P&& ... p)
+		{
+			auto& node = static_cast<SwapNode*>(version)->node;
+			if constexpr (std::is_void_v<R>)
+				node(std::forward<P>(p)...);
+			else
+				return node(std::forward<P>(p)...);
+		}
+
+		template <typename N, typename R, typename ... P>
+		void SwapNode<N, R, P...>::Destroy(SwapVersion<R, P...>* version)
+		{
+			delete static_cast<SwapNode*>(version);
+		}
+
+		inline size_t SwapShard() noexcept
+		{
+			static std::atomic<size_t> next{};
+			static thread_local size_t const shard{ next.fetch_add(1, std::memory_order_relaxed) % swap_shards };
+			return shard;
+		}
+
+		template <typename R, typename ... P>
+		R LiveNode<R(P...)>::operator()(P ... p) const
+		{
+			return (*swap)(std::forward<P>(p)...);
+		}
+
+	}
+
+	template <typename R, typename ... P>
+	template <typename N>
+	auto HotSwap<R(P...)>::MakeVersion(N&& node) -> Version*
+	{
+		using Node   = impl::SwapNode<std::decay_t<N>, R, P...>;
+		using Result = decltype(node(std::declval<P>()...));
+		static_assert(std::is_void_v<R> || std::is_convertible_v<Result, R>, "HotSwap  The subtree does not return the type of the signature.");
+		return new Node{ { &Node::Call, &Node::Destroy }, std::forward<N>(node) };
+	}
+
+	template <typename R, typename ... P>
+	template <typename T>
+	HotSwap<R(P...)>::HotSwap(Action<T> action)
+		: live{ MakeVersion(std::move(action)) }
+	{}
+
+	template <typename R, typename ... P>
+	template <typename T>
+	HotSwap<R(P...)>::HotSwap(Decision<T> decision)
+		: live{ MakeVersion(std::move(decision)) }
+	{
+		static_assert(std::is_same_v<R, bool>, "HotSwap(Decision)  The signature must return bool.");
+	}
+
+	template <typename R, typename ... P>
+	HotSwap<R(P...)>::~HotSwap()
+	{
+		Version* version = live.load(std::memory_order_acquire);
+		version->destroy(version);
+	}
+
+	template <typename R, typename ... P>
+	template <typename T>
+	void HotSwap<R(P...)>::Swap(Action<T> action)
+	{
+		Replace(MakeVersion(std::move(action)));
+	}
+
+	template <typename R, typename ... P>
+	template <typename T>
+	void HotSwap<R(P...)>::Swap(Decision<T> decision)
+	{
+		static_assert(std::is_same_v<R, bool>, "HotSwap::Swap(Decision)  The signature must return bool.");
+		Replace(MakeVersion(std::move(decision)));
+	}
+
+	template <typename R, typename ... P>
+	void HotSwap<R(P...)>::Replace(Version* next)
+	{
+		std::lock_guard lock{ swapping };
+
+		// Calls that start from here on run the next version, and count under the other parity
+		Version* const previous = live.exchange(next, std::memory_order_seq_cst);
+		uint64_t const old      = epoch.fetch_add(1, std::memory_order_seq_cst);
+
+		for (auto& shard : readers)
+			while (shard.count[old & 1].load(std::memory_order_acquire) != 0)
+				std::this_thread::yield();
+
+		previous->destroy(previous);
+	}
+
+	template <typename R, typename ... P>
+	R HotSwap<R(P...)>::operator()(P ... p) const
+	{
+		// Counted before the version is read. A call that counted under an epoch that has moved on
+		// may have been missed by the swap that moved it, so it counts again under the new one.
+		auto&    shard   = readers[impl::SwapShard()];
+		uint64_t current = epoch.load(std::memory_order_seq_cst);
+		for (;;)
+		{
+			shard.count[current & 1].fetch_add(1, std::memory_order_seq_cst);
+			uint64_t const now = epoch.load(std::memory_order_seq_cst);
+			if (now == current)
+				break;
+			shard.count[current & 1].fetch_sub(1, std::memory_order_release);
+			current = now;
+		}
+
+		struct Leave
+		{
+			std::atomic<uint32_t>& count;
+			~Leave() { count.fetch_sub(1, std::memory_order_release); }
+		}
+		leave{ shard.count[current & 1] };
+
+		Version* const version = live.load(std::memory_order_acquire);
+		return version->call(version, std::forward<P>(p)...);
+	}
+
+	template <typename S>
+	auto Live(HotSwap<S>& swap)
+	{
+		using Node = impl::LiveNode<S>;
+		if constexpr (std::is_same_v<typename std::function<S>::result_type, bool>)
+			return Decision<Node>{ Node{ &swap } };
+		else
+			return Action<Node>{ Node{ &swap } };
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,272 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	// Marks a decision that runs at most once per evaluation and set of arguments, all copies of it share the result.
+	// Objects passed by reference are told apart by their address, other arguments are copied into the cache
+	// and must be copyable and comparable with ==.
+	template <typename T>
+	auto /*Decision*/ Memo(Decision<T>);
+
+	// One evaluation: while it lives, memoized decisions on this thread run at most once.
+	// Without an evaluation they run every time.
+	class MemoContext
+	{
+	public:
+
+		MemoContext() noexcept;
+		~MemoContext();
+
+		MemoContext(MemoContext const&) = delete;
+		MemoContext& operator = (MemoContext const&) = delete;
+
+	private:
+
+		uint64_t outer;
+	};
+
+	// Same tree, every call is an evaluation of its own
+	template <typename T>
+	auto /* Action */ WithMemo(Action<T>);
+
+	namespace impl
+	{
+
+		template <typename T, typename = void>
+		struct is_equality_comparable : std::false_type {};
+
+		template <typename T>
+		struct is_equality_comparable<T, std::void_t<decltype(bool(std::declval<T const&>() == std::declval<T const&>()))>> : std::true_type {};
+
+		template <typename T>
+		constexpr bool is_equality_comparable_v = is_equality_comparable<T>::value;
+
+		// Objects passed by reference are kept by address, so they are neither copied nor compared
+		template <typename P>
+		constexpr bool memo_by_address_v = std::is_lvalue_reference_v<P> && !std::is_scalar_v<std::remove_reference_t<P>>;
+
+		template <typename P>
+		using MemoKey_t = std::conditional_t<memo_by_address_v<P>, std::remove_reference_t<P> const*, std::decay_t<P>>;
+
+		template <typename P, typename T>
+		MemoKey_t<P> MemoKey(T const&);
+
+		// Evaluations of this thread
+		class MemoTable
+		{
+		public:
+
+			static MemoTable& Local();
+			static size_t     NewId();
+
+			uint64_t epoch{};		// current evaluation, 0 when there is none
+			uint64_t last {};
+		};
+
+		// Results of the memoized decisions of this thread that take these arguments,
+		// stamped with the evaluation they belong to
+		template <typename Args>
+		class MemoResults
+		{
+		public:
+
+			static MemoResults& Local();
+
+			template <typename F>
+			bool Get(size_t id, uint64_t epoch, Args key, F&& evaluate);
+
+		private:
+
+			struct Entry
+			{
+				uint64_t                             stamp{};
+				std::vector<std::pair<Args, bool>>   seen{};
+			};
+
+			std::vector<Entry> entries{};
+		};
+
+		template <typename D>
+		struct Memoized
+		{
+			D      decision;
+			size_t id;
+
+			template <typename ... P>
+			bool operator () (P&& ...);
+		};
+
+		template <typename A>
+		struct MemoScope
+		{
+			A action;
+
+			template <typename ... P>
+			auto operator () (P&& ...);
+		};
+
+		// Suspends memoization, for callers that run one tree over several inputs at a time
+		class MemoPause
+		{
+		public:
+
+			MemoPause() noexcept;
+			~MemoPause();
+
+			MemoPause(MemoPause const&) = delete;
+			MemoPause& operator = (MemoPause const&) = delete;
+
+		private:
+
+			uint64_t outer;
+		};
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	inline MemoTable& MemoTable::Local()
+	{
+		static thread_local MemoTable table{};
+		return table;
+	}
+
+	inline size_t MemoTable::NewId()
+	{
+		static std::atomic<size_t> next{};
+		return next.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	template <typename Args>
+	MemoResults<Args>& MemoResults<Args>::Local()
+	{
+		static thread_local MemoResults results{};
+		return results;
+	}
+
+	template <typename Args>
+	template <typename F>
+	bool MemoResults<Args>::Get(size_t id, uint64_t epoch, Args key, F&& evaluate)
+	{
+		if (id >= entries.size())
+			entries.resize(id + 1);
+
+		Entry& entry = entries[id];
+		if (entry.stamp != epoch)
+		{
+			entry.stamp = epoch;
+			entry.seen.clear();
+		}
+		for (auto const& [args, value] : entry.seen)
+			if (args == key)
+				return value;
+
+		// Stored after the decision ran: a decision that throws is not cached
+		bool const value{ evaluate() };
+		entry.seen.emplace_back(std::move(key), value);
+		return value;
+	}
+
+	template <typename P, typename T>
+	MemoKey_t<P> MemoKey(T const& p)
+	{
+		if constexpr (memo_by_address_v<P>)
+			return std::addressof(p);
+		else
+			return p;
+	}
+
+	inline MemoPause::MemoPause() noexcept
+		: outer{ std::exchange(MemoTable::Local().epoch, 0) }
+	{}
+
+	inline MemoPause::~MemoPause()
+	{
+		MemoTable::Local().epoch = outer;
+	}
+
+	template <typename D>
+	template <typename ... P>
+	bool Memoized<D>::operator()(P&& ... p)
+	{
+		using Args = std::tuple<MemoKey_t<P>...>;
+		static_assert(!is_awaitable_v<decltype(decision(p...))>, "Awaitable decisions can not be memoized");
+		static_assert(std::is_copy_constructible_v<Args>, "Memo  Arguments passed by value to a memoized decision must be copyable.");
+		static_assert((is_equality_comparable_v<MemoKey_t<P>> && ...), "Memo  Arguments passed by value to a memoized decision must be comparable with ==.");
+
+		auto const epoch = MemoTable::Local().epoch;
+		if (!epoch)
+			return decision(std::forward<P>(p)...);
+
+		// Taken before the decision may move from the arguments
+		return MemoResults<Args>::Local().Get(id, epoch, Args{ MemoKey<P>(p)... }, [&] { return bool(decision(std::forward<P>(p)...)); });
+	}
+
+	template <typename A>
+	template <typename ... P>
+	auto MemoScope<A>::operator()(P&& ... p)
+	{
+		MemoContext const context{};
+		return action(std::forward<P>(p)...);
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	inline MemoContext::MemoContext() noexcept
+	{
+		auto& table = impl::MemoTable::Local();
+		outer       = table.epoch;
+		table.epoch = ++table.last;
+	}
+
+	inline MemoContext::~MemoContext()
+	{
+		impl::MemoTable::Local().epoch = outer;
+	}
+
+	template <typename T>
+	auto Memo(Decision<T> decision)
+	{
+		using Memoized = impl::Memoized<Decision<T>>;
+		return Decision<Memoized>{ Memoized{ std::move(decision), impl::MemoTable::NewId() } };
+	}
+
+	template <typename T>
+	auto WithMemo(Action<T> action)
+	{
+		using MemoScope = impl::MemoScope<Action<T>>;
+		return Action<MemoScope>{ MemoScope{ std::move(action) } };
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_ThreadPool.h"
+
+#include <array>
+
+namespace JL::action_tree
+{
+
+	// Same as a | b | ..., but the actions run at the same time on a thread pool.
+	// All actions receive the same arguments as lvalues, at the same time.
+	// Actions that return an expected give the same result as in a sequence, the error of the first one that
+	// failed, but every action has run by then.
+	template <typename ... T>
+	auto /* Action */ Parallel(Action<T>...);
+
+	template <typename ... T>
+	auto /* Action */ Parallel(ThreadPool&, Action<T>...);
+
+	namespace impl
+	{
+
+		template <typename ... A>
+		struct ParallelSequence
+		{
+			ThreadPool*      pool;
+			std::tuple<A...> actions;
+
+			template <typename ... P>
+			auto operator () (P&& ...);
+
+		private:
+
+			template <size_t ... I, typename ... P>
+			auto Run(std::index_sequence<I...>, P& ...);
+		};
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	template <typename ... A>
+	template <typename ... P>
+	auto ParallelSequence<A...>::operator()(P&& ... p)
+	{
+		return Run(std::index_sequence_for<A...>{}, p...);
+	}
+
+	template <typename ... A>
+	template <size_t ... I, typename ... P>
+	auto ParallelSequence<A...>::Run(std::index_sequence<I...>, P& ... p)
+	{
+		constexpr size_t N = sizeof...(A);
+
+		std::tuple<Slot<decltype(std::get<I>(actions)(p...))>...> slots{};
+
+		auto fill = [&](auto index)
+		{
+			constexpr size_t J = decltype(index)::value;
+			std::get<J>(slots).Fill([&]() -> decltype(auto) { return std::get<J>(actions)(p...); });
+		};
+
+		using Fill = decltype(fill);
+		static constexpr void (*jump[])(PoolTask&){
+			+[](PoolTask& task) { (*static_cast<Fill*>(task.context))(std::integral_constant<size_t, I>{}); }...
+		};
+
+		// Every action but the first goes to the pool, the first runs right here
+		std::array<PoolTask, N> tasks{};
+		std::array<bool, N> queued{};
+		for (size_t i{ 1 }; i < N; ++i)
+		{
+			tasks[i].run     = jump[i];
+			tasks[i].context = &fill;
+			queued[i]        = pool->Submit(tasks[i]);
+		}
+
+		std::exception_ptr error{};
+		try
+		{
+			fill(std::integral_constant<size_t, 0>{});
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		// Join, tasks the pool had no room for run inline
+		for (size_t i{ 1 }; i < N; ++i)
+		{
+			try
+			{
+				if (queued[i])
+					pool->Wait(tasks[i]);
+				else
+					jump[i](tasks[i]);
+			}
+			catch (...)
+			{
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+		if (error)
+			std::rethrow_exception(error);
+
+		using X = SequenceExpected_t<decltype(std::get<I>(actions)(p...))...>;
+		SlotStage<decltype(slots)> stage{ slots };
+		return Gather<0, N, X>(stage, std::tuple<>{});
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename ... T>
+	auto Parallel(Action<T> ... actions)
+	{
+		return Parallel(ThreadPool::Default(), std::move(actions)...);
+	}
+
+	template <typename ... T>
+	auto Parallel(ThreadPool& pool, Action<T> ... actions)
+	{
+		using ParallelSequence = impl::ParallelSequence<Action<T>...>;
+		return Action<ParallelSequence>{ ParallelSequence{ &pool, { std::move(actions)... } } };
+	}
+
+}
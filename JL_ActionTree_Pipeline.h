@@ -0,0 +1,513 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	// Counters of one stage of a pipeline
+	struct StageStats
+	{
+		size_t items;       // items the stage has finished
+		double busy;        // seconds spent in its action
+		double throughput;  // items per second, from the start of the pipeline until the stage ended
+		double occupancy;   // average fill of the queue in front of the stage, 0 to 1
+		size_t peak;        // most items ever waiting in that queue
+	};
+
+	// Chain of actions where each stage is called with the result of the one before it, unlike a | b.
+	// Every stage runs on a thread of its own, stages are connected by bounded lock-free ring buffers.
+	template <typename In, typename ... T>
+	auto /* Pipeline */ Pipeline(Action<T>...);
+
+	template <typename In, typename ... T>
+	auto /* Pipeline */ Pipeline(size_t capacity, Action<T>...);
+
+	namespace impl
+	{
+
+		// Single producer, single consumer ring buffer. Items are built in place and moved out.
+		template <typename T>
+		class Ring
+		{
+		public:
+
+			explicit Ring(size_t capacity);
+			~Ring();
+
+			Ring(Ring const&) = delete;
+			Ring& operator = (Ring const&) = delete;
+
+			// Producer
+			bool Full();
+			template <typename F>
+			void Emplace(F&& make);		// only when not full
+			void Close();
+			bool Closed() const noexcept;
+
+			// Consumer
+			T*   Front();				// nullptr when empty
+			void Pop();
+			bool Drained();				// closed and empty
+
+			size_t Size()     const noexcept;
+			size_t Capacity() const noexcept;
+
+		private:
+
+			struct Cell { alignas(T) unsigned char bytes[sizeof(T)]; };
+
+			std::unique_ptr<Cell[]> cells;
+			size_t const            mask;
+
+			alignas(64) std::atomic<size_t> head{};		// next to pop, written by the consumer
+			size_t                          tailCache{};
+			alignas(64) std::atomic<size_t> tail{};		// next to push, written by the producer
+			size_t                          headCache{};
+			std::atomic<bool>               closed{};
+
+			T* At(size_t i) noexcept { return std::launder(reinterpret_cast<T*>(cells[i & mask].bytes)); }
+		};
+
+		// Types that flow through a pipeline: its input, then the result of every stage
+		template <typename In, typename ... A>
+		struct PipelineTypes { using type = std::tuple<In>; };
+
+		template <typename In, typename A, typename ... B>
+		struct PipelineTypes<In, A, B...>
+		{
+			using R = decltype(std::declval<A&>()(std::declval<In&&>()));
+			static_assert(sizeof...(B) == 0 || !std::is_void_v<R>, "Only the last stage of a pipeline may return void");
+
+			using Next = std::conditional_t<std::is_void_v<R>, std::monostate, std::decay_t<R>>;
+			using type = decltype(std::tuple_cat(std::declval<std::tuple<In>>(), std::declval<typename PipelineTypes<Next, B...>::type>()));
+		};
+
+		template <typename In, typename ... A>
+		class Pipeline
+		{
+			using Types = typename PipelineTypes<In, A...>::type;
+
+			template <size_t I>
+			using Item = std::tuple_element_t<I, Types>;
+
+			static constexpr size_t N = sizeof...(A);
+
+		public:
+
+			// Result of the last stage
+			using Out = decltype(std::declval<std::tuple_element_t<N - 1, std::tuple<A...>>&>()(std::declval<Item<N - 1>&&>()));
+
+			Pipeline(size_t capacity, A ... actions);
+
+			// Stops the stages, whatever is still queued is dropped
+			~Pipeline();
+
+			Pipeline(Pipeline const&) = delete;
+			Pipeline& operator = (Pipeline const&) = delete;
+
+			// Blocks while the first queue is full, false once the pipeline is closed or has stopped.
+			// Push and Close are called from one thread, Pop from one thread.
+			bool Push(In);
+
+			// No more input, the stages finish what is queued and end
+			void Close();
+
+			// Next result of the last stage, blocks until there is one, nothing once the pipeline has ended
+			auto Pop();
+
+			// Closes, waits for every stage to end and rethrows the first error of a stage.
+			// When the last stage returns values, pop them first.
+			void Wait();
+
+			std::array<StageStats, N> Stats() const;
+
+		private:
+
+			struct alignas(64) Counters
+			{
+				std::atomic<size_t>  items{};
+				std::atomic<int64_t> busy{};
+				std::atomic<size_t>  filled{};
+				std::atomic<size_t>  peak{};
+				std::atomic<int64_t> end{ -1 };
+			};
+
+			using Clock = std::chrono::steady_clock;
+
+			template <typename ... R>
+			static auto MakeRings(std::tuple<R...>*, size_t capacity) -> std::tuple<Ring<R>...>*;
+
+			using Rings = std::remove_pointer_t<decltype(MakeRings(static_cast<Types*>(nullptr), 0))>;
+
+			std::tuple<A...>            actions;
+			Rings                       rings;
+			std::array<Counters, N>     counters{};
+			Clock::time_point const     start{ Clock::now() };
+			std::atomic<bool>           stop{};
+			std::mutex                  errorLock;
+			std::exception_ptr          error{};
+			std::vector<std::thread>    threads{};
+
+			template <size_t ... I>
+			Pipeline(size_t capacity, std::index_sequence<I...>, A ... actions);
+
+			template <size_t ... I>
+			void Start(std::index_sequence<I...>);
+
+			template <size_t I>
+			void Stage();
+
+			template <size_t ... I>
+			std::array<StageStats, N> Stats(std::index_sequence<I...>) const;
+
+			static StageStats StageStatsOf(Counters const&, size_t capacity, int64_t now);
+
+			// Nanoseconds
+			int64_t Elapsed() const { return Elapsed(start); }
+			int64_t Elapsed(Clock::time_point) const;
+
+			template <typename R>
+			bool WaitForRoom(Ring<R>&);
+
+			static void Backoff(unsigned& spin);
+		};
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	//-----------
+	//   Ring
+
+	template <typename T>
+	Ring<T>::Ring(size_t capacity)
+		: cells{ nullptr }
+		, mask{ [capacity] { size_t size{ 1 }; while (size < capacity) size <<= 1; return size - 1; }() }
+	{
+		cells.reset(new Cell[mask + 1]);
+	}
+
+	template <typename T>
+	Ring<T>::~Ring()
+	{
+		for (size_t i{ head.load() }, end{ tail.load() }; i != end; ++i)
+			At(i)->~T();
+	}
+
+	template <typename T>
+	bool Ring<T>::Full()
+	{
+		size_t const t{ tail.load(std::memory_order_relaxed) };
+		if (t - headCache <= mask)
+			return false;
+		headCache = head.load(std::memory_order_acquire);
+		return t - headCache > mask;
+	}
+
+	template <typename T>
+	template <typename F>
+	void Ring<T>::Emplace(F&& make)
+	{
+		size_t const t{ tail.load(std::memory_order_relaxed) };
+		::new (static_cast<void*>(cells[t & mask].bytes)) T(make());
+		tail.store(t + 1, std::memory_order_release);
+	}
+
+	template <typename T>
+	void Ring<T>::Close()
+	{
+		closed.store(true, std::memory_order_release);
+	}
+
+	template <typename T>
+	bool Ring<T>::Closed() const noexcept
+	{
+		return closed.load(std::memory_order_acquire);
+	}
+
+	template <typename T>
+	T* Ring<T>::Front()
+	{
+		size_t const h{ head.load(std::memory_order_relaxed) };
+		if (h == tailCache)
+		{
+			tailCache = tail.load(std::memory_order_acquire);
+			if (h == tailCache)
+				return nullptr;
+		}
+		return At(h);
+	}
+
+	template <typename T>
+	void Ring<T>::Pop()
+	{
+		size_t const h{ head.load(std::memory_order_relaxed) };
+		At(h)->~T();
+		head.store(h + 1, std::memory_order_release);
+	}
+
+	template <typename T>
+	bool Ring<T>::Drained()
+	{
+		// Closed is only set after the last push, so it has to be read first
+		return closed.load(std::memory_order_acquire) && !Front();
+	}
+
+	template <typename T>
+	size_t Ring<T>::Size() const noexcept
+	{
+		return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+	}
+
+	template <typename T>
+	size_t Ring<T>::Capacity() const noexcept
+	{
+		return mask + 1;
+	}
+
+	//---------------
+	//   Pipeline
+
+	template <typename In, typename ... A>
+	Pipeline<In, A...>::Pipeline(size_t capacity, A ... actions)
+		: Pipeline{ capacity, std::make_index_sequence<N + 1>{}, std::move(actions)... }
+	{}
+
+	template <typename In, typename ... A>
+	template <size_t ... I>
+	Pipeline<In, A...>::Pipeline(size_t capacity, std::index_sequence<I...>, A ... actions)
+		: actions{ std::move(actions)... }
+		, rings{ (void(I), capacity)... }
+	{
+		Start(std::make_index_sequence<N>{});
+	}
+
+	template <typename In, typename ... A>
+	template <size_t ... I>
+	void Pipeline<In, A...>::Start(std::index_sequence<I...>)
+	{
+		(threads.emplace_back([this] { Stage<I>(); }), ...);
+	}
+
+	template <typename In, typename ... A>
+	Pipeline<In, A...>::~Pipeline()
+	{
+		stop = true;
+		for (auto& thread : threads)
+			if (thread.joinable())
+				thread.join();
+	}
+
+	template <typename In, typename ... A>
+	bool Pipeline<In, A...>::Push(In item)
+	{
+		auto& ring = std::get<0>(rings);
+		if (ring.Closed() || !WaitForRoom(ring))
+			return false;
+		ring.Emplace([&item]() -> In&& { return std::move(item); });
+		return true;
+	}
+
+	template <typename In, typename ... A>
+	void Pipeline<In, A...>::Close()
+	{
+		std::get<0>(rings).Close();
+	}
+
+	template <typename In, typename ... A>
+	auto Pipeline<In, A...>::Pop()
+	{
+		static_assert(!std::is_void_v<Out>, "The last stage does not return anything to pop");
+
+		auto& ring = std::get<N>(rings);
+		for (unsigned spin{};;)
+		{
+			if (auto* item = ring.Front())
+			{
+				Maybe<Item<N>> out{ std::move(*item) };
+				ring.Pop();
+				return out;
+			}
+			if (ring.Drained() || stop.load(std::memory_order_relaxed))
+				return Maybe<Item<N>>{};
+			Backoff(spin);
+		}
+	}
+
+	template <typename In, typename ... A>
+	void Pipeline<In, A...>::Wait()
+	{
+		Close();
+		for (auto& thread : threads)
+			if (thread.joinable())
+				thread.join();
+
+		std::lock_guard guard{ errorLock };
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	template <typename In, typename ... A>
+	auto Pipeline<In, A...>::Stats() const -> std::array<StageStats, N>
+	{
+		return Stats(std::make_index_sequence<N>{});
+	}
+
+	template <typename In, typename ... A>
+	template <size_t ... I>
+	auto Pipeline<In, A...>::Stats(std::index_sequence<I...>) const -> std::array<StageStats, N>
+	{
+		int64_t const now{ Elapsed() };
+		return { StageStatsOf(counters[I], std::get<I>(rings).Capacity(), now)... };
+	}
+
+	template <typename In, typename ... A>
+	StageStats Pipeline<In, A...>::StageStatsOf(Counters const& counter, size_t capacity, int64_t now)
+	{
+		size_t const  items{ counter.items.load(std::memory_order_relaxed) };
+		int64_t const end  { counter.end.load(std::memory_order_relaxed) };
+		double const  alive{ double(end < 0 ? now : end) * 1e-9 };
+		return StageStats{
+			items,
+			double(counter.busy.load(std::memory_order_relaxed)) * 1e-9,
+			alive > 0 ? double(items) / alive : 0.,
+			items ? double(counter.filled.load(std::memory_order_relaxed)) / double(items) / double(capacity) : 0.,
+			counter.peak.load(std::memory_order_relaxed),
+		};
+	}
+
+	template <typename In, typename ... A>
+	int64_t Pipeline<In, A...>::Elapsed(Clock::time_point since) const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+	}
+
+	template <typename In, typename ... A>
+	template <size_t I>
+	void Pipeline<In, A...>::Stage()
+	{
+		auto& action   = std::get<I>(actions);
+		auto& in       = std::get<I>(rings);
+		auto& out      = std::get<I + 1>(rings);
+		auto& counter  = counters[I];
+
+		constexpr bool sink = I + 1 == N && std::is_void_v<Out>;
+
+		try
+		{
+			for (unsigned spin{}; !stop.load(std::memory_order_relaxed);)
+			{
+				auto* item = in.Front();
+				if (!item)
+				{
+					if (in.Drained())
+						break;
+					Backoff(spin);
+					continue;
+				}
+				spin = 0;
+
+				size_t const size{ in.Size() };
+				counter.filled.fetch_add(size, std::memory_order_relaxed);
+				if (size > counter.peak.load(std::memory_order_relaxed))
+					counter.peak.store(size, std::memory_order_relaxed);
+
+				if constexpr (!sink)
+					if (!WaitForRoom(out))
+						break;
+
+				auto const begin = Clock::now();
+				if constexpr (sink)
+					action(std::move(*item));
+				else
+					out.Emplace([&]() -> decltype(auto) { return action(std::move(*item)); });
+				counter.busy.fetch_add(Elapsed(begin), std::memory_order_relaxed);
+				counter.items.fetch_add(1, std::memory_order_relaxed);
+
+				in.Pop();
+			}
+		}
+		catch (...)
+		{
+			{
+				std::lock_guard guard{ errorLock };
+				if (!error)
+					error = std::current_exception();
+			}
+			stop = true;
+		}
+
+		counter.end.store(Elapsed(), std::memory_order_relaxed);
+		out.Close();
+	}
+
+	template <typename In, typename ... A>
+	template <typename R>
+	bool Pipeline<In, A...>::WaitForRoom(Ring<R>& ring)
+	{
+		for (unsigned spin{}; ring.Full(); )
+		{
+			if (stop.load(std::memory_order_relaxed))
+				return false;
+			Backoff(spin);
+		}
+		return !stop.load(std::memory_order_relaxed);
+	}
+
+	template <typename In, typename ... A>
+	void Pipeline<In, A...>::Backoff(unsigned& spin)
+	{
+		// Spin for a short wait, then give up the core, then sleep when the stage stays idle
+		if (++spin < 64)
+			return;
+		if (spin < 1024)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds{ 50 });
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename In, typename ... T>
+	auto Pipeline(Action<T> ... actions)
+	{
+		return Pipeline<In>(size_t{ 64 }, std::move(actions)...);
+	}
+
+	template <typename In, typename ... T>
+	auto Pipeline(size_t capacity, Action<T> ... actions)
+	{
+		return impl::Pipeline<In, Action<T>...>{ capacity, std::move(actions)... };
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,680 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef JL_ACTION_TREE_PROFILE
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#endif
+
+// Profiling is opt-in: define JL_ACTION_TREE_PROFILE for the whole program before including the action tree.
+// Every action and decision then counts its calls and times them, otherwise all of this compiles to nothing.
+// Without the define the action tree does not include this header, include it for Label and the reports.
+
+namespace JL::action_tree
+{
+
+	// What a node did since the last reset
+	struct ProfileEntry
+	{
+		uint32_t                 id;
+		uint32_t                 parent;		// first node that called it, 0 for a root
+		std::string              kind;			// "action", "decision", "and", "stack", ...
+		std::string              label;
+		uint64_t                 calls;
+		std::optional<uint64_t>  taken;			// decisions: true, edges: fired, conditionals: action ran
+		std::chrono::nanoseconds inclusive;
+		std::chrono::nanoseconds exclusive;		// without the time spent in child nodes
+	};
+
+	// Names the node in reports and traces. Copies of a node share their counters and label.
+	template <typename N>
+	N Label(N node, std::string_view);
+
+	// Nodes that were called, in the order they were first called
+	std::vector<ProfileEntry> ProfileSnapshot();
+
+	// Clears all counters and the trace
+	void ProfileReset();
+
+	// Text report, one line per node, indented below the node that called it
+	void ProfileReport(std::ostream&);
+
+	// Chrome trace JSON (chrome://tracing, Perfetto), one complete event per call
+	void ProfileTrace(std::ostream&);
+
+	// Header with a likelihood for every labelled decision, to compile the next build with:
+	//
+	//   namespace hints
+	//   {
+	//       constexpr int isBroken = -1;	// taken 0.2% of 51200 calls
+	//   }
+	//
+	//   Hint<hints::isBroken>(isBroken) && repair || ...
+	//
+	// 1 when it held in at least `bias` of its calls, -1 when it failed as often, 0 otherwise.
+	void ProfileHints(std::ostream&, std::string_view space = "hints", double bias = 0.9);
+
+#ifdef JL_ACTION_TREE_PROFILE
+
+	namespace impl
+	{
+
+		struct ProfileRecord
+		{
+			static constexpr uint32_t unseen = ~uint32_t{};
+
+			ProfileRecord(uint32_t id, char const* kind) noexcept : id{ id }, kind{ kind } {}
+
+			uint32_t const            id;
+			std::atomic<char const*>  kind;			// null until a leaf is called
+			std::atomic<uint32_t>     parent{ unseen };
+			std::atomic<uint32_t>     order{};
+			std::atomic<uint64_t>     calls{};
+			std::atomic<uint64_t>     taken{};
+			std::atomic<bool>         tested{};
+			std::atomic<uint64_t>     inclusive{};	// ns
+			std::atomic<uint64_t>     exclusive{};	// ns
+			std::string               label{};		// guarded by the profiler
+		};
+
+		struct TraceEvent
+		{
+			uint32_t node;
+			uint64_t begin;		// ns
+			uint64_t duration;	// ns
+		};
+
+		struct TraceBuffer
+		{
+			std::mutex              mutex{};
+			std::vector<TraceEvent> events{};
+			uint32_t                thread{};
+		};
+
+		// All records and traces of the program, records live until the end of the program
+		class Profiler
+		{
+		public:
+
+			static constexpr size_t traceLimit = size_t{ 1 } << 20;		// events per thread
+
+			static Profiler& Global();
+
+			ProfileRecord* Add(char const* kind);
+			uint64_t       Now() const noexcept;
+			void           Trace(uint32_t node, uint64_t begin, uint64_t duration);
+
+			std::mutex                                mutex{};
+			std::deque<ProfileRecord>                 records{};
+			std::vector<std::shared_ptr<TraceBuffer>> buffers{};
+			std::atomic<uint32_t>                     order{};
+			std::atomic<uint64_t>                     dropped{};
+
+		private:
+
+			std::chrono::steady_clock::time_point origin{ std::chrono::steady_clock::now() };
+		};
+
+		template <typename D>                             struct Not;
+		template <typename A, typename B>                 struct Or;
+		template <typename A, typename B>                 struct And;
+		template <typename D, typename A, bool Rising>    struct Edge;
+		template <typename D, typename A>                 struct Conditional;
+		template <typename A, typename ... B>             struct Cascade;
+		template <typename ... A>                         struct Sequence;
+		template <typename A, typename V>                 struct Visit;
+		template <typename K, typename A, typename ... C> struct SwitchDispatch;
+		template <typename ... A>                         struct ParallelSequence;
+		template <typename D>                             struct Memoized;
+		template <typename A>                             struct MemoScope;
+		template <bool All, typename ... D>               struct AdaptiveGroup;
+		template <typename S, bool Const>                 struct Firewall;
+		template <typename S>                             struct LiveNode;
+		template <typename S>                             struct ResumeSequence;
+		template <typename C>                             struct ResumeCascade;
+		template <typename C>                             struct ResumeConditional;
+		template <typename N>                             struct Cached;
+		template <typename D, int L>                      struct Hinted;
+		template <typename C>                             struct TruthTableStack;
+
+		// What the report calls a node, and how its outcome is counted
+		struct ProfileNode
+		{
+			static constexpr char const* kind        = nullptr;		// leaf: "decision" or "action", from its result
+			static constexpr bool        edge        = false;		// taken: the action fired
+			static constexpr bool        rising      = false;
+			static constexpr bool        conditional = false;		// taken: the first child was true
+		};
+
+		template <typename F>
+		struct ProfileTraits : ProfileNode {};
+
+		template <typename D>
+		struct ProfileTraits<Not<D>>                 : ProfileNode { static constexpr char const* kind = "not"; };
+		template <typename A, typename B>
+		struct ProfileTraits<Or<A, B>>               : ProfileNode { static constexpr char const* kind = "or"; };
+		template <typename A, typename B>
+		struct ProfileTraits<And<A, B>>              : ProfileNode { static constexpr char const* kind = "and"; };
+		template <typename A, typename ... B>
+		struct ProfileTraits<Cascade<A, B...>>       : ProfileNode { static constexpr char const* kind = "stack"; };
+		template <typename ... A>
+		struct ProfileTraits<Sequence<A...>>         : ProfileNode { static constexpr char const* kind = "sequence"; };
+		template <typename A, typename V>
+		struct ProfileTraits<Visit<A, V>>            : ProfileNode { static constexpr char const* kind = "visit"; };
+		template <typename K, typename A, typename ... C>
+		struct ProfileTraits<SwitchDispatch<K, A, C...>> : ProfileNode { static constexpr char const* kind = "switch"; };
+		template <typename ... A>
+		struct ProfileTraits<ParallelSequence<A...>> : ProfileNode { static constexpr char const* kind = "parallel"; };
+		template <typename D>
+		struct ProfileTraits<Memoized<D>>            : ProfileNode { static constexpr char const* kind = "memo"; };
+		template <typename A>
+		struct ProfileTraits<MemoScope<A>>           : ProfileNode { static constexpr char const* kind = "memo scope"; };
+		template <bool All, typename ... D>
+		struct ProfileTraits<AdaptiveGroup<All, D...>> : ProfileNode { static constexpr char const* kind = All ? "adaptive and" : "adaptive or"; };
+		template <typename S, bool Const>
+		struct ProfileTraits<Firewall<S, Const>>     : ProfileNode { static constexpr char const* kind = "firewall"; };
+		template <typename S>
+		struct ProfileTraits<LiveNode<S>>            : ProfileNode { static constexpr char const* kind = "hot swap"; };
+		template <typename S>
+		struct ProfileTraits<ResumeSequence<S>>      : ProfileNode { static constexpr char const* kind = "resumable sequence"; };
+		template <typename C>
+		struct ProfileTraits<ResumeCascade<C>>       : ProfileNode { static constexpr char const* kind = "resumable stack"; };
+		template <typename C>
+		struct ProfileTraits<ResumeConditional<C>>   : ProfileNode { static constexpr char const* kind = "resumable conditional"; };
+		template <typename N>
+		struct ProfileTraits<Cached<N>>              : ProfileNode { static constexpr char const* kind = "reactive"; };
+		template <typename D, int L>
+		struct ProfileTraits<Hinted<D, L>>           : ProfileNode { static constexpr char const* kind = L > 0 ? "likely" : "unlikely"; };
+		template <typename C>
+		struct ProfileTraits<TruthTableStack<C>>     : ProfileNode { static constexpr char const* kind = "truth table"; };
+
+		template <typename D, typename A, bool Rising>
+		struct ProfileTraits<Edge<D, A, Rising>> : ProfileNode
+		{
+			static constexpr char const* kind   = Rising ? "rising edge" : "falling edge";
+			static constexpr bool        edge   = true;
+			static constexpr bool        rising = Rising;
+		};
+
+		template <typename D, typename A>
+		struct ProfileTraits<Conditional<D, A>> : ProfileNode
+		{
+			static constexpr char const* kind        = "conditional";
+			static constexpr bool        conditional = true;
+		};
+
+		// Times one call of a node, nested calls on the same thread are its children
+		class ProfileScope
+		{
+		public:
+
+			explicit ProfileScope(ProfileRecord*) noexcept;
+			~ProfileScope();
+
+			ProfileScope(ProfileScope const&) = delete;
+			ProfileScope& operator = (ProfileScope const&) = delete;
+
+			template <typename N, typename ... P>
+			decltype(auto) Run(N&, P&& ...);
+
+		private:
+
+			static inline thread_local ProfileScope* top{};
+
+			ProfileRecord* record;
+			ProfileScope*  parent;
+			uint64_t       begin;
+			uint64_t       children{};
+			int8_t         outcome{ -1 };
+			int8_t         first  { -1 };		// outcome of the first child that has one
+		};
+
+		// One timed call of a node
+		template <typename N, typename ... P>
+		decltype(auto) Profiled(ProfileRecord*, N&, P&& ...);
+
+		// Nodes built while compiling have no record, they run without being timed
+		template <typename F>
+		struct Probe
+		{
+			ProfileRecord* record{};
+
+			constexpr Probe()
+			{
+#ifdef __cpp_lib_is_constant_evaluated
+				if (std::is_constant_evaluated())
+					return;
+#endif
+				record = Profiler::Global().Add(ProfileTraits<F>::kind);
+			}
+		};
+
+	}
+
+#endif
+
+}
+
+
+
+// Implementation
+
+#ifdef JL_ACTION_TREE_PROFILE
+
+namespace JL::action_tree::impl
+{
+
+	//---------------
+	//   Profiler
+
+	inline Profiler& Profiler::Global()
+	{
+		static Profiler profiler{};
+		return profiler;
+	}
+
+	inline ProfileRecord* Profiler::Add(char const* kind)
+	{
+		std::lock_guard lock{ mutex };
+		return &records.emplace_back(uint32_t(records.size() + 1), kind);
+	}
+
+	inline uint64_t Profiler::Now() const noexcept
+	{
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+	}
+
+	inline void Profiler::Trace(uint32_t node, uint64_t begin, uint64_t duration)
+	{
+		thread_local std::shared_ptr<TraceBuffer> local{};
+		if (!local)
+		{
+			local = std::make_shared<TraceBuffer>();
+			std::lock_guard lock{ mutex };
+			local->thread = uint32_t(buffers.size() + 1);
+			buffers.push_back(local);
+		}
+
+		std::lock_guard lock{ local->mutex };
+		if (local->events.size() < traceLimit)
+			local->events.push_back({ node, begin, duration });
+		else
+			dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline std::string ProfileName(ProfileRecord const& record)
+	{
+		char const* kind = record.kind.load(std::memory_order_relaxed);
+		if (!kind)
+			kind = "node";
+		if (record.label.empty())
+			return std::string{ kind } + " #" + std::to_string(record.id);
+		else
+			return record.label + " (" + kind + ")";
+	}
+
+	//-------------------
+	//   ProfileScope
+
+	inline ProfileScope::ProfileScope(ProfileRecord* record) noexcept
+		: record{ record }
+		, parent{ top }
+	{
+		auto& profiler = Profiler::Global();
+		if (record->parent.load(std::memory_order_relaxed) == ProfileRecord::unseen)
+		{
+			uint32_t unseen{ ProfileRecord::unseen };
+			if (record->parent.compare_exchange_strong(unseen, parent ? parent->record->id : 0, std::memory_order_relaxed))
+				record->order.store(profiler.order.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		top   = this;
+		begin = profiler.Now();
+	}
+
+	inline ProfileScope::~ProfileScope()
+	{
+		auto&          profiler  = Profiler::Global();
+		uint64_t const inclusive = profiler.Now() - begin;
+		uint64_t const exclusive = inclusive > children ? inclusive - children : 0;
+
+		record->calls    .fetch_add(1,         std::memory_order_relaxed);
+		record->inclusive.fetch_add(inclusive, std::memory_order_relaxed);
+		record->exclusive.fetch_add(exclusive, std::memory_order_relaxed);
+		if (outcome >= 0)
+		{
+			record->taken.fetch_add(uint64_t(outcome), std::memory_order_relaxed);
+			if (!record->tested.load(std::memory_order_relaxed))
+				record->tested.store(true, std::memory_order_relaxed);
+		}
+		if (!record->kind.load(std::memory_order_relaxed))
+			record->kind.store(outcome >= 0 ? "decision" : "action", std::memory_order_relaxed);
+
+		profiler.Trace(record->id, begin, inclusive);
+
+		if (parent)
+		{
+			parent->children += inclusive;
+			if (parent->first < 0)
+				parent->first = outcome;
+		}
+		top = parent;
+	}
+
+	template <typename N, typename ... P>
+	decltype(auto) ProfileScope::Run(N& node, P&& ... p)
+	{
+		using Traits = ProfileTraits<std::remove_const_t<N>>;
+		using R      = decltype(node(std::forward<P>(p)...));
+
+		if constexpr (Traits::edge && std::is_same_v<R, bool>)
+		{
+			bool const before = node.State();
+			bool       test   = node(std::forward<P>(p)...);
+			outcome = test != before && test == Traits::rising;
+			return test;
+		}
+		else
+		if constexpr (Traits::conditional && std::is_void_v<R>)
+		{
+			node(std::forward<P>(p)...);
+			outcome = first;
+		}
+		else
+		if constexpr (Traits::conditional)
+		{
+			R result = node(std::forward<P>(p)...);
+			outcome = first;
+			return result;
+		}
+		else
+		if constexpr (std::is_same_v<R, bool>)
+		{
+			bool result = node(std::forward<P>(p)...);
+			outcome = result;
+			return result;
+		}
+		else
+			return node(std::forward<P>(p)...);
+	}
+
+	template <typename N, typename ... P>
+	decltype(auto) Profiled(ProfileRecord* record, N& node, P&& ... p)
+	{
+		ProfileScope scope{ record };
+		return scope.Run(node, std::forward<P>(p)...);
+	}
+
+	//-------------
+	//   Export
+
+	inline std::string JsonEscape(std::string_view text)
+	{
+		std::string out{};
+		out.reserve(text.size());
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\', out += c;
+			else
+			if (uint8_t(c) < 0x20)
+			{
+				char code[8];
+				std::snprintf(code, sizeof code, "\\u%04x", unsigned(c));
+				out += code;
+			}
+			else
+				out += c;
+		}
+		return out;
+	}
+
+	// ns as µs with three decimals
+	inline std::string Micro(uint64_t ns)
+	{
+		std::string fraction{ std::to_string(ns % 1000) };
+		return std::to_string(ns / 1000) + '.' + std::string(3 - fraction.size(), '0') + fraction;
+	}
+
+	// A label as a C++ identifier
+	inline std::string Identifier(std::string_view label)
+	{
+		std::string out{};
+		for (char c : label)
+			out += std::isalnum(uint8_t(c)) ? c : '_';
+		if (out.empty() || std::isdigit(uint8_t(out.front())))
+			out.insert(out.begin(), '_');
+		return out;
+	}
+
+}
+
+#endif
+
+namespace JL::action_tree
+{
+
+	template <typename N>
+	N Label(N node, [[maybe_unused]] std::string_view label)
+	{
+#ifdef JL_ACTION_TREE_PROFILE
+		auto& profiler = impl::Profiler::Global();
+		std::lock_guard lock{ profiler.mutex };
+		if (node.probe.record)
+			node.probe.record->label = label;
+#endif
+		return node;
+	}
+
+	inline std::vector<ProfileEntry> ProfileSnapshot()
+	{
+		std::vector<ProfileEntry> entries{};
+#ifdef JL_ACTION_TREE_PROFILE
+		auto& profiler = impl::Profiler::Global();
+		std::lock_guard lock{ profiler.mutex };
+
+		std::vector<impl::ProfileRecord const*> called{};
+		for (auto const& record : profiler.records)
+			if (record.calls.load(std::memory_order_relaxed) != 0)
+				called.push_back(&record);
+		std::sort(called.begin(), called.end(), [](auto a, auto b) { return a->order.load(std::memory_order_relaxed) < b->order.load(std::memory_order_relaxed); });
+
+		entries.reserve(called.size());
+		for (auto record : called)
+		{
+			char const* kind = record->kind.load(std::memory_order_relaxed);
+			entries.push_back({
+				record->id,
+				record->parent.load(std::memory_order_relaxed),
+				kind ? kind : "node",
+				record->label,
+				record->calls.load(std::memory_order_relaxed),
+				record->tested.load(std::memory_order_relaxed) ? std::optional<uint64_t>{ record->taken.load(std::memory_order_relaxed) } : std::nullopt,
+				std::chrono::nanoseconds(record->inclusive.load(std::memory_order_relaxed)),
+				std::chrono::nanoseconds(record->exclusive.load(std::memory_order_relaxed)),
+			});
+		}
+#endif
+		return entries;
+	}
+
+	inline void ProfileReset()
+	{
+#ifdef JL_ACTION_TREE_PROFILE
+		auto& profiler = impl::Profiler::Global();
+		std::lock_guard lock{ profiler.mutex };
+
+		for (auto& record : profiler.records)
+		{
+			record.parent   .store(impl::ProfileRecord::unseen, std::memory_order_relaxed);
+			record.order    .store(0,     std::memory_order_relaxed);
+			record.calls    .store(0,     std::memory_order_relaxed);
+			record.taken    .store(0,     std::memory_order_relaxed);
+			record.tested   .store(false, std::memory_order_relaxed);
+			record.inclusive.store(0,     std::memory_order_relaxed);
+			record.exclusive.store(0,     std::memory_order_relaxed);
+		}
+		for (auto& buffer : profiler.buffers)
+		{
+			std::lock_guard events{ buffer->mutex };
+			buffer->events.clear();
+		}
+		profiler.order  .store(0, std::memory_order_relaxed);
+		profiler.dropped.store(0, std::memory_order_relaxed);
+#endif
+	}
+
+	inline void ProfileReport([[maybe_unused]] std::ostream& out)
+	{
+#ifdef JL_ACTION_TREE_PROFILE
+		auto const entries = ProfileSnapshot();
+
+		// Every node below the node that called it first
+		std::vector<std::vector<size_t>> children(entries.size());
+		std::vector<size_t>              roots{};
+		for (size_t i{}; i < entries.size(); ++i)
+		{
+			auto parent = std::find_if(entries.begin(), entries.end(), [&](auto const& e) { return e.id == entries[i].parent; });
+			if (entries[i].parent == 0 || parent == entries.end() || parent->id == entries[i].id)
+				roots.push_back(i);
+			else
+				children[size_t(parent - entries.begin())].push_back(i);
+		}
+
+		double total{};
+		for (auto const& e : entries)
+			total += double(e.exclusive.count());
+
+		std::ostringstream text{};
+		text << std::fixed << std::setprecision(3);
+		text << std::left << std::setw(48) << "node" << std::right
+		     << std::setw(12) << "calls"
+		     << std::setw(12) << "taken"
+		     << std::setw(12) << "not taken"
+		     << std::setw(12) << "incl ms"
+		     << std::setw(12) << "excl ms"
+		     << std::setw(9)  << "excl %" << '\n';
+
+		auto line = [&](auto& self, size_t i, size_t depth) -> void
+		{
+			auto const& e = entries[i];
+			std::string name(depth * 2, ' ');
+			name += e.label.empty() ? e.kind + " #" + std::to_string(e.id) : e.label + " (" + e.kind + ")";
+
+			text << std::left << std::setw(48) << name << std::right << std::setw(12) << e.calls;
+			if (e.taken)
+				text << std::setw(12) << *e.taken << std::setw(12) << e.calls - *e.taken;
+			else
+				text << std::setw(12) << '-' << std::setw(12) << '-';
+			text << std::setw(12) << double(e.inclusive.count()) / 1e6
+			     << std::setw(12) << double(e.exclusive.count()) / 1e6
+			     << std::setw(9)  << std::setprecision(1) << (total > 0 ? 100 * double(e.exclusive.count()) / total : 0.0) << std::setprecision(3)
+			     << '\n';
+
+			for (size_t child : children[i])
+				self(self, child, depth + 1);
+		};
+		for (size_t root : roots)
+			line(line, root, 0);
+
+		if (auto dropped = impl::Profiler::Global().dropped.load(std::memory_order_relaxed))
+			text << dropped << " trace events dropped\n";
+
+		out << text.str();
+#endif
+	}
+
+	inline void ProfileTrace(std::ostream& out)
+	{
+#ifdef JL_ACTION_TREE_PROFILE
+		auto& profiler = impl::Profiler::Global();
+		std::lock_guard lock{ profiler.mutex };
+
+		std::vector<std::string> names{};
+		std::vector<std::string> kinds{};
+		for (auto const& record : profiler.records)
+		{
+			char const* kind = record.kind.load(std::memory_order_relaxed);
+			names.push_back(impl::JsonEscape(impl::ProfileName(record)));
+			kinds.push_back(kind ? kind : "node");
+		}
+
+		out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool comma{};
+		for (auto const& buffer : profiler.buffers)
+		{
+			std::lock_guard events{ buffer->mutex };
+			for (auto const& event : buffer->events)
+			{
+				out << (comma ? ",\n" : "\n")
+				    << "{\"name\":\"" << names[event.node - 1] << "\",\"cat\":\"" << kinds[event.node - 1]
+				    << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread
+				    << ",\"ts\":" << impl::Micro(event.begin) << ",\"dur\":" << impl::Micro(event.duration) << '}';
+				comma = true;
+			}
+		}
+		out << "\n]}\n";
+#else
+		out << "{\"traceEvents\":[]}\n";
+#endif
+	}
+
+	inline void ProfileHints(std::ostream& out, std::string_view space, [[maybe_unused]] double bias)
+	{
+		out << "#pragma once\n\n// Generated by ProfileHints\n\nnamespace " << space << "\n{\n";
+#ifdef JL_ACTION_TREE_PROFILE
+		// Copies of a decision under one label count as one, conditionals and edges count something else
+		struct Hint
+		{
+			std::string name;
+			uint64_t    calls;
+			uint64_t    taken;
+		};
+		std::vector<Hint> hints{};
+		for (auto const& e : ProfileSnapshot())
+		{
+			if (e.label.empty() || !e.taken || e.kind.find("conditional") != e.kind.npos || e.kind.find("edge") != e.kind.npos)
+				continue;
+			std::string name = impl::Identifier(e.label);
+			auto hint = std::find_if(hints.begin(), hints.end(), [&](auto const& h) { return h.name == name; });
+			if (hint == hints.end())
+				hints.push_back({ std::move(name), e.calls, *e.taken });
+			else
+				hint->calls += e.calls, hint->taken += *e.taken;
+		}
+
+		std::ostringstream text{};
+		text << std::fixed << std::setprecision(1);
+		for (auto const& h : hints)
+		{
+			double const rate = double(h.taken) / double(h.calls);
+			int const    hint = rate >= bias ? 1 : 1 - rate >= bias ? -1 : 0;
+			text << "\tconstexpr int " << h.name << " = " << hint << ";\t// taken " << 100 * rate << "% of " << h.calls << " calls\n";
+		}
+		out << text.str();
+#endif
+		out << "}\n";
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,448 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Shared.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	template <typename N>
+	class ReactiveTree;
+
+	// A decision that only depends on these inputs, not on the arguments it is called with. Inputs are numbers or enumerators.
+	template <typename T, typename ... I>
+	auto /*Decision*/ Reads(Decision<T>, I ... inputs);
+
+	// Same tree, keeping the result of every decision whose inputs are all known: those made with Reads, and !, & and | of them.
+	// A call only evaluates the decisions that read an input that was touched since it last ran. Other nodes run as they always do:
+	// `&`, `&&`/`||` and `+`/`-` take the kept results as if their decisions had run.
+	template <typename T>
+	auto /*ReactiveTree*/ Reactive(Action<T>);
+
+	template <typename T>
+	auto /*ReactiveTree*/ Reactive(Decision<T>);
+
+	namespace impl
+	{
+
+		template <typename D>
+		struct Reads
+		{
+			D                     decision;
+			std::vector<uint32_t> inputs;
+
+			template <typename ... P>
+			bool operator () (P&& ...);
+		};
+
+		// Result of a decision, valid until one of its inputs is touched
+		template <typename N>
+		struct Cached
+		{
+			N        node;
+			uint32_t cell;
+			bool     value{};
+
+			template <typename ... P>
+			bool operator () (P&& ...);
+		};
+
+		// Which results of the reactive tree that is running on this thread are still valid
+		struct ReactiveCells
+		{
+			uint8_t* valid;
+
+			static inline thread_local ReactiveCells const* current{};
+		};
+
+		class ReactiveScope
+		{
+		public:
+
+			explicit ReactiveScope(uint8_t* valid) noexcept;
+			~ReactiveScope();
+
+			ReactiveScope(ReactiveScope const&) = delete;
+			ReactiveScope& operator = (ReactiveScope const&) = delete;
+
+		private:
+
+			ReactiveCells        cells;
+			ReactiveCells const* outer;
+		};
+
+		// Cells handed out while a tree is made reactive, and the cells that depend on each input
+		struct ReactiveBuild
+		{
+			std::vector<std::vector<uint32_t>> dependents;
+			uint32_t                           cells{};
+
+			uint32_t Cell(std::vector<uint32_t> const& inputs);
+		};
+
+		// All inputs of the decision are known
+		template <typename N>
+		constexpr bool is_declared_v = false;
+
+		template <typename D>
+		constexpr bool is_declared_v<Reads<D>> = true;
+		template <typename F>
+		constexpr bool is_declared_v<Decision<F>> = is_declared_v<F>;
+		template <typename D>
+		constexpr bool is_declared_v<Not<D>> = is_declared_v<D>;
+		template <typename A, typename B>
+		constexpr bool is_declared_v<And<A, B>> = is_declared_v<A> && is_declared_v<B>;
+		template <typename A, typename B>
+		constexpr bool is_declared_v<Or<A, B>> = is_declared_v<A> && is_declared_v<B>;
+
+		template <typename D>
+		auto NodeChildren(Reads<D>&);
+		template <typename N>
+		auto NodeChildren(Cached<N>&);
+
+		// The kept result is not per instance of a shared tree
+		template <typename N, typename ... P>
+		struct KeepsState<Cached<N>, P...> : std::true_type {};
+
+		// The tree with its known decisions cached, `inputs` gets what the node reads
+		template <typename N>
+		N React(N, ReactiveBuild&, std::vector<uint32_t>& inputs);
+
+		template <typename F>
+		auto React(Action<F>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename F>
+		auto React(Decision<F>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename D>
+		auto React(Reads<D>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename D>
+		auto React(Not<D>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename A, typename B>
+		auto React(And<A, B>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename A, typename B>
+		auto React(Or<A, B>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename D, typename A, bool Rising>
+		auto React(Edge<D, A, Rising>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename D, typename A>
+		auto React(Conditional<D, A>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename A, typename ... B>
+		auto React(Cascade<A, B...>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+		template <typename ... A>
+		auto React(Sequence<A...>, ReactiveBuild&, std::vector<uint32_t>& inputs);
+
+	}
+
+	template <typename N>
+	class ReactiveTree
+	{
+	public:
+
+		ReactiveTree(N, impl::ReactiveBuild);
+
+		// The input changed, decisions that read it run again on the next call
+		template <typename I>
+		void Touch(I input) noexcept;
+
+		// Every decision runs again on the next call
+		void TouchAll() noexcept;
+
+		// Number of kept results
+		size_t Cells() const noexcept { return valid.size(); }
+
+		template <typename ... P>
+		decltype(auto) operator () (P&& ...);
+
+	private:
+
+		N                                  node;
+		std::vector<uint8_t>               valid;
+		std::vector<std::vector<uint32_t>> dependents;
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	template <typename D>
+	template <typename ... P>
+	bool Reads<D>::operator()(P&& ... p)
+	{
+		return decision(std::forward<P>(p)...);
+	}
+
+	template <typename N>
+	template <typename ... P>
+	bool Cached<N>::operator()(P&& ... p)
+	{
+		static_assert(!is_awaitable_v<decltype(node(p...))>, "Awaitable decisions can not be reactive");
+
+		auto cells = ReactiveCells::current;
+		if (!cells)
+			return node(std::forward<P>(p)...);
+
+		uint8_t& valid = cells->valid[cell];
+		if (!valid)
+		{
+			// Marked valid after the decision ran, a decision that throws is not kept
+			value = node(std::forward<P>(p)...);
+			valid = 1;
+		}
+		return value;
+	}
+
+	template <typename D>
+	auto NodeChildren(Reads<D>& node)
+	{
+		return std::tie(node.decision);
+	}
+
+	template <typename N>
+	auto NodeChildren(Cached<N>& node)
+	{
+		return std::tie(node.node);
+	}
+
+	inline ReactiveScope::ReactiveScope(uint8_t* valid) noexcept
+		: cells{ valid }
+		, outer{ ReactiveCells::current }
+	{
+		ReactiveCells::current = &cells;
+	}
+
+	inline ReactiveScope::~ReactiveScope()
+	{
+		ReactiveCells::current = outer;
+	}
+
+	inline uint32_t ReactiveBuild::Cell(std::vector<uint32_t> const& inputs)
+	{
+		for (uint32_t input : inputs)
+		{
+			if (input >= dependents.size())
+				dependents.resize(size_t{ input } + 1);
+			dependents[input].push_back(cells);
+		}
+		return cells++;
+	}
+
+	//-----------
+	//   React
+
+	template <typename N>
+	N React(N node, ReactiveBuild&, std::vector<uint32_t>&)
+	{
+		return node;
+	}
+
+	template <typename F>
+	auto React(Action<F> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		auto reacted = React(static_cast<F&&>(node), build, inputs);
+		return Action<decltype(reacted)>{ std::move(reacted) };
+	}
+
+	template <typename F>
+	auto React(Decision<F> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		auto reacted = React(static_cast<F&&>(node), build, inputs);
+		return Decision<decltype(reacted)>{ std::move(reacted) };
+	}
+
+	template <typename D>
+	auto React(Reads<D> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		inputs = node.inputs;
+		uint32_t const cell = build.Cell(inputs);
+		return Cached<Reads<D>>{ std::move(node), cell };
+	}
+
+	template <typename D>
+	auto React(Not<D> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		// As cheap as the decision below it, which is kept already
+		auto decision = React(std::move(node.decision), build, inputs);
+		return Not<decltype(decision)>{ std::move(decision) };
+	}
+
+	// And and Or, kept when both sides are known
+	template <template <typename, typename> typename G, typename A, typename B>
+	auto ReactBoth(G<A, B> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		std::vector<uint32_t> more{};
+		auto a = React(std::move(node.a), build, inputs);
+		auto b = React(std::move(node.b), build, more);
+
+		using Reacted = G<decltype(a), decltype(b)>;
+		if constexpr (is_declared_v<A> && is_declared_v<B>)
+		{
+			inputs.insert(inputs.end(), more.begin(), more.end());
+			std::sort(inputs.begin(), inputs.end());
+			inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+			uint32_t const cell = build.Cell(inputs);
+			return Cached<Reacted>{ Reacted{ std::move(a), std::move(b) }, cell };
+		}
+		else
+			return Reacted{ std::move(a), std::move(b) };
+	}
+
+	template <typename A, typename B>
+	auto React(And<A, B> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		return ReactBoth(std::move(node), build, inputs);
+	}
+
+	template <typename A, typename B>
+	auto React(Or<A, B> node, ReactiveBuild& build, std::vector<uint32_t>& inputs)
+	{
+		return ReactBoth(std::move(node), build, inputs);
+	}
+
+	template <typename D, typename A, bool Rising>
+	auto React(Edge<D, A, Rising> node, ReactiveBuild& build, std::vector<uint32_t>&)
+	{
+		// The edge itself runs every call, it only fires when the kept result changes
+		std::vector<uint32_t> inputs{};
+		auto decision = React(std::move(node.decision), build, inputs);
+		auto action   = React(std::move(node.action), build, inputs);
+		return Edge<decltype(decision), decltype(action), Rising>{ std::move(decision), std::move(action), node.on, node.slot };
+	}
+
+	template <typename D, typename A>
+	auto React(Conditional<D, A> node, ReactiveBuild& build, std::vector<uint32_t>&)
+	{
+		std::vector<uint32_t> inputs{};
+		auto decision = React(std::move(node.decision), build, inputs);
+		auto action   = React(std::move(node.action), build, inputs);
+		return Conditional<decltype(decision), decltype(action)>{ std::move(decision), std::move(action) };
+	}
+
+	template <typename A, typename ... B>
+	auto React(Cascade<A, B...> node, ReactiveBuild& build, std::vector<uint32_t>&)
+	{
+		std::vector<uint32_t> inputs{};
+		return std::apply(
+			[&](auto&& ... branches)
+			{
+				auto branch = [&](auto&& b)
+				{
+					auto decision = React(std::move(b.decision), build, inputs);
+					auto action   = React(std::move(b.action), build, inputs);
+					return Branch<decltype(decision), decltype(action)>{ std::move(decision), std::move(action) };
+				};
+				// Braces keep the branches in order, so are the cells
+				std::tuple reacted{ branch(std::move(branches))... };
+				auto fallback = React(std::move(node.fallback), build, inputs);
+				return std::apply(
+					[&](auto&& ... b)
+					{
+						using Cascade = Cascade<decltype(fallback), std::decay_t<decltype(b)>...>;
+						return Cascade{ { std::move(b)... }, std::move(fallback) };
+					},
+					std::move(reacted)
+				);
+			},
+			std::move(node.branches)
+		);
+	}
+
+	template <typename ... A>
+	auto React(Sequence<A...> node, ReactiveBuild& build, std::vector<uint32_t>&)
+	{
+		std::vector<uint32_t> inputs{};
+		return std::apply(
+			[&](auto&& ... actions)
+			{
+				std::tuple reacted{ React(std::move(actions), build, inputs)... };
+				return std::apply(
+					[](auto&& ... a) { return Sequence<std::decay_t<decltype(a)>...>{ { std::move(a)... } }; },
+					std::move(reacted)
+				);
+			},
+			std::move(node.actions)
+		);
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename T, typename ... I>
+	auto Reads(Decision<T> decision, I ... inputs)
+	{
+		using Reads = impl::Reads<Decision<T>>;
+		return Decision<Reads>{ Reads{ std::move(decision), { static_cast<uint32_t>(inputs)... } } };
+	}
+
+	template <typename T>
+	auto Reactive(Action<T> action)
+	{
+		impl::ReactiveBuild   build{};
+		std::vector<uint32_t> inputs{};
+		auto node = impl::React(std::move(action), build, inputs);
+		return ReactiveTree<decltype(node)>{ std::move(node), std::move(build) };
+	}
+
+	template <typename T>
+	auto Reactive(Decision<T> decision)
+	{
+		impl::ReactiveBuild   build{};
+		std::vector<uint32_t> inputs{};
+		auto node = impl::React(std::move(decision), build, inputs);
+		return ReactiveTree<decltype(node)>{ std::move(node), std::move(build) };
+	}
+
+	//------------------
+	//   ReactiveTree
+
+	template <typename N>
+	ReactiveTree<N>::ReactiveTree(N node, impl::ReactiveBuild build)
+		: node{ std::move(node) }
+		, valid(build.cells)
+		, dependents{ std::move(build.dependents) }
+	{}
+
+	template <typename N>
+	template <typename I>
+	void ReactiveTree<N>::Touch(I input) noexcept
+	{
+		auto const index = size_t(static_cast<uint32_t>(input));
+		if (index < dependents.size())
+			for (uint32_t cell : dependents[index])
+				valid[cell] = 0;
+	}
+
+	template <typename N>
+	void ReactiveTree<N>::TouchAll() noexcept
+	{
+		std::fill(valid.begin(), valid.end(), uint8_t{});
+	}
+
+	template <typename N>
+	template <typename ... P>
+	decltype(auto) ReactiveTree<N>::operator()(P&& ... p)
+	{
+		impl::ReactiveScope scope{ valid.data() };
+		return node(std::forward<P>(p)...);
+	}
+
+}
\ No newline at end of file
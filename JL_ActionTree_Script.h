@@ -0,0 +1,802 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	template <typename>
+	class Registry;
+
+	template <typename>
+	class ScriptAction;
+
+	template <typename>
+	class ScriptDecision;
+
+	// A script that does not parse, or that names a primitive that is not registered
+	class ScriptError : public std::runtime_error
+	{
+	public:
+
+		ScriptError(std::string const& message, size_t position);
+
+		// Offset in the source
+		size_t Position() const noexcept { return position; }
+
+	private:
+
+		size_t position;
+	};
+
+	namespace impl
+	{
+
+		// Instructions of a compiled script. Decisions leave their result in a flag, actions add theirs to the result.
+		enum class Op : uint8_t
+		{
+			Test,			// flag = decision[arg]
+			TestOrJump,		// flag = decision[slot], to arg when it is false
+			TestAndJump,	// flag = decision[slot], to arg when it is true
+			Not,			// flag = !flag
+			JumpIfFalse,	// to arg
+			JumpIfTrue,		// to arg
+			Jump,			// to arg
+			Edge,			// flag is the input of edge `slot`, to arg when it does not fire
+			State,			// flag = state of edge `slot`
+			Call,			// result += action[arg]
+			Run,			// action[arg], without its result
+			End,
+		};
+
+		struct Instruction
+		{
+			Op       op;
+			bool     rising{};
+			uint16_t slot{};
+			uint32_t arg{};
+		};
+
+		template <typename R, typename ... P>
+		struct Primitive
+		{
+			void* object;
+			R   (*call)(void*, P& ...);
+		};
+
+		// Primitives of a registry, shared with every script it compiled
+		struct PrimitiveEntry
+		{
+			std::shared_ptr<void> object;
+			void                (*call)();		// Primitive::call, of the decision or action signature
+			bool                  decision;
+			bool                  valueless;	// an action that returns void, in a registry that does not
+		};
+
+		struct ScriptNode;
+
+		// Code and tables of a script, shared by ScriptAction and ScriptDecision
+		template <typename R, typename ... P>
+		struct Program
+		{
+			std::vector<Instruction>                code;
+			std::vector<Primitive<bool, P...>>      decisions;
+			std::vector<Primitive<R, P...>>         actions;
+			std::vector<uint8_t>                    edges;		// state of every edge
+			std::vector<std::shared_ptr<void>>      owners;
+
+			template <bool Decides>
+			auto Run(P& ...);
+		};
+
+		using Primitives = std::unordered_map<std::string, PrimitiveEntry>;
+
+		template <typename R, typename ... P>
+		Program<R, P...> Compile(Primitives const&, std::string_view source, bool decision);
+
+	}
+
+	// Named actions and decisions for trees that are only known at run time.
+	// Scripts use the operators of the tree, with the same precedence as in C++:
+	//
+	//   registry.ParseAction("isQueued +open -close & read | serialize | write");
+	//
+	// Primitives get their arguments as lvalues and are shared by every script of the registry.
+	template <typename R, typename ... P>
+	class Registry<R(P...)>
+	{
+	public:
+
+		template <typename T>
+		void Add(std::string name, Action<T>);
+
+		template <typename T>
+		void Add(std::string name, Decision<T>);
+
+		// Throws ScriptError
+		ScriptAction  <R(P...)> ParseAction  (std::string_view source) const;
+		ScriptDecision<R(P...)> ParseDecision(std::string_view source) const;
+
+	private:
+
+		impl::Primitives primitives;
+	};
+
+	// Compiled action, void or Maybe<R>: results of a sequence are added up when they can be, otherwise the last one is kept.
+	// Can be put in a tree like any other action.
+	template <typename R, typename ... P>
+	class ScriptAction<R(P...)>
+	{
+	public:
+
+		explicit ScriptAction(impl::Program<R, P...>);
+
+		auto operator () (P ...);
+
+		size_t Instructions() const noexcept { return program.code.size(); }
+
+	private:
+
+		impl::Program<R, P...> program;
+	};
+
+	// Compiled decision, of a registry with signature R(P...)
+	template <typename R, typename ... P>
+	class ScriptDecision<R(P...)>
+	{
+	public:
+
+		explicit ScriptDecision(impl::Program<R, P...>);
+
+		bool operator () (P ...);
+
+		size_t Instructions() const noexcept { return program.code.size(); }
+
+	private:
+
+		impl::Program<R, P...> program;
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	inline ScriptError::ScriptError(std::string const& message, size_t position)
+		: std::runtime_error{ message + " at " + std::to_string(position) }
+		, position{ position }
+	{}
+
+}
+
+namespace JL::action_tree::impl
+{
+
+	//------------
+	//   Parser
+
+	// Tree of a script before it is compiled
+	struct ScriptNode
+	{
+		enum Kind : uint8_t { Leaf, Not, Edge, All, Any, Sequence, Conditional, Cascade };
+		enum Type : uint8_t { Decision, Action, Branch };
+
+		Kind                    kind;
+		Type                    type;
+		bool                    rising{};
+		uint32_t                primitive{};
+		size_t                  position{};
+		std::vector<ScriptNode> children{};		// Cascade: decision, action, ..., fallback
+	};
+
+	class ScriptParser
+	{
+	public:
+
+		ScriptParser(Primitives const& primitives, std::string_view source) noexcept : primitives{ primitives }, source{ source } {}
+
+		ScriptNode Parse();
+
+		// Primitives in the order the script first uses them
+		std::vector<PrimitiveEntry const*> used{};
+
+	private:
+
+		ScriptNode ParseCascade();
+		ScriptNode ParseBranch();
+		ScriptNode ParseSequence();
+		ScriptNode ParseConditional();
+		ScriptNode ParseEdge();
+		ScriptNode ParseUnary();
+
+		bool Accept(std::string_view token);
+		void Skip();
+		[[noreturn]] void Fail(std::string const& message, size_t position) const { throw ScriptError{ message, position }; }
+
+		Primitives const& primitives;
+		std::string_view  source;
+		size_t            at{};
+	};
+
+	inline void ScriptParser::Skip()
+	{
+		while (at < source.size())
+		{
+			if (source[at] == ' ' || source[at] == '\t' || source[at] == '\r' || source[at] == '\n')
+				++at;
+			else
+			if (source.substr(at, 2) == "//")
+				while (at < source.size() && source[at] != '\n')
+					++at;
+			else
+				break;
+		}
+	}
+
+	inline bool ScriptParser::Accept(std::string_view token)
+	{
+		Skip();
+		if (source.substr(at, token.size()) != token)
+			return false;
+		// `|` is not the start of `||`, nor `&` of `&&`
+		if (token.size() == 1 && (token == "|" || token == "&") && source.substr(at + 1, 1) == token)
+			return false;
+		at += token.size();
+		return true;
+	}
+
+	inline ScriptNode ScriptParser::Parse()
+	{
+		ScriptNode node = ParseCascade();
+		Skip();
+		if (at != source.size())
+			Fail("Unexpected '" + std::string{ source.substr(at, 1) } + "'", at);
+		if (node.type == ScriptNode::Branch)
+			Fail("A branch stack needs an action to fall back on", node.position);
+		return node;
+	}
+
+	// a || b, d && a || ... || a
+	inline ScriptNode ScriptParser::ParseCascade()
+	{
+		ScriptNode first = ParseBranch();
+		if (!Accept("||"))
+			return first;
+
+		ScriptNode node{ ScriptNode::Any, first.type, {}, {}, first.position };
+		node.children.push_back(std::move(first));
+		do
+			node.children.push_back(ParseBranch());
+		while (Accept("||"));
+
+		if (node.type == ScriptNode::Decision)
+		{
+			for (auto& child : node.children)
+				if (child.type != ScriptNode::Decision)
+					Fail("Expected a decision", child.position);
+			return node;
+		}
+
+		// Flatten the branches into decision, action, ..., fallback
+		ScriptNode cascade{ ScriptNode::Cascade, ScriptNode::Action, {}, {}, node.position };
+		for (size_t i{}; i < node.children.size(); ++i)
+		{
+			auto& child = node.children[i];
+			if (child.type == ScriptNode::Branch)
+				for (auto& part : child.children)
+					cascade.children.push_back(std::move(part));
+			else
+			if (child.type == ScriptNode::Action && i + 1 == node.children.size())
+				cascade.children.push_back(std::move(child));
+			else
+				Fail("Expected a branch `decision && action`", child.position);
+		}
+		if (cascade.children.size() % 2 == 0)
+			cascade.type = ScriptNode::Branch;	// no fallback yet
+		return cascade;
+	}
+
+	// d && d, d && a
+	inline ScriptNode ScriptParser::ParseBranch()
+	{
+		ScriptNode node = ParseSequence();
+		while (Accept("&&"))
+		{
+			if (node.type != ScriptNode::Decision)
+				Fail("Expected a decision before &&", node.position);
+			ScriptNode right = ParseSequence();
+			if (right.type == ScriptNode::Branch)
+				Fail("Expected a decision or action after &&", right.position);
+
+			auto const kind = right.type == ScriptNode::Decision ? ScriptNode::All : ScriptNode::Cascade;
+			ScriptNode both{ kind, right.type == ScriptNode::Decision ? ScriptNode::Decision : ScriptNode::Branch, {}, {}, node.position };
+			both.children.push_back(std::move(node));
+			both.children.push_back(std::move(right));
+			node = std::move(both);
+		}
+		return node;
+	}
+
+	// d | d, a | a
+	inline ScriptNode ScriptParser::ParseSequence()
+	{
+		ScriptNode node = ParseConditional();
+		while (Accept("|"))
+		{
+			ScriptNode right = ParseConditional();
+			if (node.type != right.type || node.type == ScriptNode::Branch)
+				Fail("Expected two decisions or two actions around |", right.position);
+
+			ScriptNode both{ node.type == ScriptNode::Decision ? ScriptNode::Any : ScriptNode::Sequence, node.type, {}, {}, node.position };
+			both.children.push_back(std::move(node));
+			both.children.push_back(std::move(right));
+			node = std::move(both);
+		}
+		return node;
+	}
+
+	// d & d, d & a
+	inline ScriptNode ScriptParser::ParseConditional()
+	{
+		ScriptNode node = ParseEdge();
+		while (Accept("&"))
+		{
+			if (node.type != ScriptNode::Decision)
+				Fail("Expected a decision before &", node.position);
+			ScriptNode right = ParseEdge();
+			if (right.type == ScriptNode::Branch)
+				Fail("Expected a decision or action after &", right.position);
+
+			auto const kind = right.type == ScriptNode::Decision ? ScriptNode::All : ScriptNode::Conditional;
+			ScriptNode both{ kind, right.type, {}, {}, node.position };
+			both.children.push_back(std::move(node));
+			both.children.push_back(std::move(right));
+			node = std::move(both);
+		}
+		return node;
+	}
+
+	// d + a, d - a
+	inline ScriptNode ScriptParser::ParseEdge()
+	{
+		ScriptNode node = ParseUnary();
+		for (;;)
+		{
+			bool rising = Accept("+");
+			if (!rising && !Accept("-"))
+				return node;
+
+			if (node.type != ScriptNode::Decision)
+				Fail("Expected a decision before an edge", node.position);
+			ScriptNode action = ParseUnary();
+			if (action.type != ScriptNode::Action)
+				Fail("Expected an action after an edge", action.position);
+
+			ScriptNode edge{ ScriptNode::Edge, ScriptNode::Decision, rising, {}, node.position };
+			edge.children.push_back(std::move(node));
+			edge.children.push_back(std::move(action));
+			node = std::move(edge);
+		}
+	}
+
+	// !d, (...), name
+	inline ScriptNode ScriptParser::ParseUnary()
+	{
+		Skip();
+		size_t const start = at;
+
+		if (Accept("!"))
+		{
+			ScriptNode decision = ParseUnary();
+			if (decision.type != ScriptNode::Decision)
+				Fail("Expected a decision after !", decision.position);
+			ScriptNode node{ ScriptNode::Not, ScriptNode::Decision, {}, {}, start };
+			node.children.push_back(std::move(decision));
+			return node;
+		}
+
+		if (Accept("("))
+		{
+			ScriptNode node = ParseCascade();
+			if (!Accept(")"))
+				Fail("Expected )", at);
+			return node;
+		}
+
+		while (at < source.size() && (std::isalnum(static_cast<unsigned char>(source[at])) || source[at] == '_'))
+			++at;
+		if (at == start)
+			Fail(at == source.size() ? "Unexpected end" : "Unexpected '" + std::string{ source.substr(at, 1) } + "'", at);
+
+		auto const name  = source.substr(start, at - start);
+		auto const found = primitives.find(std::string{ name });
+		if (found == primitives.end())
+			Fail("Unknown primitive '" + std::string{ name } + "'", start);
+
+		auto const& entry = found->second;
+		uint32_t index{};
+		for (; index < used.size(); ++index)
+			if (used[index] == &entry)
+				break;
+		if (index == used.size())
+			used.push_back(&entry);
+
+		return ScriptNode{ ScriptNode::Leaf, entry.decision ? ScriptNode::Decision : ScriptNode::Action, {}, index, start };
+	}
+
+	//--------------
+	//   Compiler
+
+	template <typename R, typename ... P>
+	class ScriptCompiler
+	{
+	public:
+
+		ScriptCompiler(Program<R, P...>& program, std::vector<uint32_t> const& tables, std::vector<bool> const& valueless, bool discard) noexcept
+			: program{ program }, tables{ tables }, valueless{ valueless }, discard{ discard } {}
+
+		void Emit(ScriptNode const&);
+
+	private:
+
+		size_t Add(Op op, uint32_t arg = 0)
+		{
+			program.code.push_back({ op, false, 0, arg });
+			return program.code.size() - 1;
+		}
+
+		// A test and the jump after it are one instruction, unless something jumps in between
+		size_t AddJump(Op op)
+		{
+			auto& code = program.code;
+			if (code.size() > label && code.back().op == Op::Test && code.back().arg <= UINT16_MAX)
+			{
+				code.back() = { op == Op::JumpIfFalse ? Op::TestOrJump : Op::TestAndJump, false, uint16_t(code.back().arg), 0 };
+				return code.size() - 1;
+			}
+			return Add(op);
+		}
+
+		void Patch(size_t jump) noexcept
+		{
+			label = program.code.size();
+			program.code[jump].arg = uint32_t(label);
+		}
+
+		Program<R, P...>&            program;
+		std::vector<uint32_t> const& tables;	// index of every used primitive in the decision or action table
+		std::vector<bool> const&     valueless;
+		bool                         discard;	// results of actions are not used, below an edge or in a decision
+		size_t                       label{};	// last place that is jumped to
+	};
+
+	template <typename R, typename ... P>
+	void ScriptCompiler<R, P...>::Emit(ScriptNode const& node)
+	{
+		auto const& children = node.children;
+		switch (node.kind)
+		{
+		case ScriptNode::Leaf:
+			if (node.type == ScriptNode::Decision)
+				Add(Op::Test, tables[node.primitive]);
+			else
+				Add(discard || valueless[node.primitive] ? Op::Run : Op::Call, tables[node.primitive]);
+			break;
+
+		case ScriptNode::Not:
+			Emit(children[0]);
+			Add(Op::Not);
+			break;
+
+		case ScriptNode::All:
+		case ScriptNode::Any:
+		{
+			Emit(children[0]);
+			std::vector<size_t> exits{};
+			for (size_t i{ 1 }; i < children.size(); ++i)
+			{
+				exits.push_back(AddJump(node.kind == ScriptNode::All ? Op::JumpIfFalse : Op::JumpIfTrue));
+				Emit(children[i]);
+			}
+			for (size_t exit : exits)
+				Patch(exit);
+			break;
+		}
+
+		case ScriptNode::Edge:
+		{
+			if (program.edges.size() > UINT16_MAX)
+				throw ScriptError{ "Too many edges", node.position };
+			auto const slot = uint16_t(program.edges.size());
+			program.edges.push_back(!node.rising);
+
+			Emit(children[0]);
+			size_t const edge = Add(Op::Edge);
+			program.code[edge].rising = node.rising;
+			program.code[edge].slot   = slot;
+			bool const outer = std::exchange(discard, true);
+			Emit(children[1]);
+			discard = outer;
+			program.code[Add(Op::State)].slot = slot;
+			Patch(edge);
+			break;
+		}
+
+		case ScriptNode::Sequence:
+			for (auto& child : children)
+				Emit(child);
+			break;
+
+		case ScriptNode::Conditional:
+		{
+			Emit(children[0]);
+			size_t const skip = AddJump(Op::JumpIfFalse);
+			Emit(children[1]);
+			Patch(skip);
+			break;
+		}
+
+		case ScriptNode::Cascade:
+		{
+			std::vector<size_t> exits{};
+			size_t i{};
+			for (; i + 1 < children.size(); i += 2)
+			{
+				Emit(children[i]);
+				size_t const next = AddJump(Op::JumpIfFalse);
+				Emit(children[i + 1]);
+				exits.push_back(Add(Op::Jump));
+				Patch(next);
+			}
+			Emit(children[i]);
+			for (size_t exit : exits)
+				Patch(exit);
+			break;
+		}
+		}
+	}
+
+	template <typename R, typename ... P>
+	Program<R, P...> Compile(Primitives const& primitives, std::string_view source, bool decision)
+	{
+		ScriptParser parser{ primitives, source };
+		ScriptNode const root = parser.Parse();
+		if (decision != (root.type == ScriptNode::Decision))
+			throw ScriptError{ decision ? "Expected a decision" : "Expected an action", root.position };
+
+		Program<R, P...>      program{};
+		std::vector<uint32_t> tables{};
+		std::vector<bool>     valueless{};
+		for (PrimitiveEntry const* entry : parser.used)
+		{
+			program.owners.push_back(entry->object);
+			valueless.push_back(entry->valueless);
+			if (entry->decision)
+			{
+				tables.push_back(uint32_t(program.decisions.size()));
+				program.decisions.push_back({ entry->object.get(), reinterpret_cast<bool(*)(void*, P& ...)>(entry->call) });
+			}
+			else
+			{
+				tables.push_back(uint32_t(program.actions.size()));
+				program.actions.push_back({ entry->object.get(), reinterpret_cast<R(*)(void*, P& ...)>(entry->call) });
+			}
+		}
+
+		ScriptCompiler<R, P...>{ program, tables, valueless, decision }.Emit(root);
+		program.code.push_back({ Op::End });
+		return program;
+	}
+
+	//-----------------
+	//   Interpreter
+
+	template <typename R, typename ... P>
+	template <bool Decides>
+	auto Program<R, P...>::Run(P& ... p)
+	{
+		constexpr bool valued = !Decides && !std::is_void_v<R>;
+		using Result = std::conditional_t<valued, Maybe<R>, std::monostate>;
+
+		Result result{};
+		bool   flag{};
+
+		// Locals, the primitives could change any member as far as the compiler knows
+		Instruction const* const      start     = code.data();
+		Primitive<bool, P...>* const  decisions = this->decisions.data();
+		Primitive<R, P...>* const     actions   = this->actions.data();
+		uint8_t* const                edges     = this->edges.data();
+
+		for (Instruction const* at = start;; )
+		{
+			Instruction const& instruction = *at++;
+			switch (instruction.op)
+			{
+			case Op::Test:
+			{
+				auto& decision = decisions[instruction.arg];
+				flag = decision.call(decision.object, p...);
+				break;
+			}
+			case Op::TestOrJump:
+			{
+				auto& decision = decisions[instruction.slot];
+				flag = decision.call(decision.object, p...);
+				if (!flag)
+					at = start + instruction.arg;
+				break;
+			}
+			case Op::TestAndJump:
+			{
+				auto& decision = decisions[instruction.slot];
+				flag = decision.call(decision.object, p...);
+				if (flag)
+					at = start + instruction.arg;
+				break;
+			}
+			case Op::Not:
+				flag = !flag;
+				break;
+			case Op::JumpIfFalse:
+				if (!flag)
+					at = start + instruction.arg;
+				break;
+			case Op::JumpIfTrue:
+				if (flag)
+					at = start + instruction.arg;
+				break;
+			case Op::Jump:
+				at = start + instruction.arg;
+				break;
+			case Op::Edge:
+			{
+				uint8_t& last = edges[instruction.slot];
+				bool const fires = flag != bool(last) && flag == instruction.rising;
+				last = flag;
+				if (!fires)
+					at = start + instruction.arg;
+				break;
+			}
+			case Op::State:
+				flag = edges[instruction.slot];
+				break;
+			case Op::Call:
+			{
+				auto& action = actions[instruction.arg];
+				if constexpr (valued)
+				{
+					if constexpr (is_addable_v<R, R>)
+						result = result ? R(std::move(*result) + action.call(action.object, p...)) : action.call(action.object, p...);
+					else
+						result = action.call(action.object, p...);
+				}
+				else
+					action.call(action.object, p...);
+				break;
+			}
+			case Op::Run:
+			{
+				auto& action = actions[instruction.arg];
+				(void)action.call(action.object, p...);
+				break;
+			}
+			case Op::End:
+				if constexpr (Decides)
+					return flag;
+				else
+				if constexpr (valued)
+					return result;
+				else
+					return;
+			}
+		}
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	//--------------
+	//   Registry
+
+	template <typename R, typename ... P>
+	template <typename T>
+	void Registry<R(P...)>::Add(std::string name, Action<T> action)
+	{
+		using Result = decltype(action(std::declval<P&>()...));
+		constexpr bool valueless = std::is_void_v<Result> && !std::is_void_v<R>;
+		static_assert(std::is_void_v<R> || valueless || std::is_convertible_v<Result, R>, "Registry::Add(Action)  The action does not return the type of the signature.");
+		static_assert(!valueless || std::is_default_constructible_v<R>, "Registry::Add(Action)  An action that returns void needs a signature that returns void or a default constructible type.");
+
+		R(*call)(void*, P& ...) = [](void* self, P& ... p) -> R
+		{
+			if constexpr (valueless)
+			{
+				(*static_cast<Action<T>*>(self))(p...);
+				return R{};		// never used, the script runs it without its result
+			}
+			else
+			if constexpr (std::is_void_v<R>)
+				(*static_cast<Action<T>*>(self))(p...);
+			else
+				return (*static_cast<Action<T>*>(self))(p...);
+		};
+		primitives[std::move(name)] = { std::make_shared<Action<T>>(std::move(action)), reinterpret_cast<void(*)()>(call), false, valueless };
+	}
+
+	template <typename R, typename ... P>
+	template <typename T>
+	void Registry<R(P...)>::Add(std::string name, Decision<T> decision)
+	{
+		bool(*call)(void*, P& ...) = [](void* self, P& ... p) -> bool
+		{
+			return (*static_cast<Decision<T>*>(self))(p...);
+		};
+		primitives[std::move(name)] = { std::make_shared<Decision<T>>(std::move(decision)), reinterpret_cast<void(*)()>(call), true, false };
+	}
+
+	template <typename R, typename ... P>
+	ScriptAction<R(P...)> Registry<R(P...)>::ParseAction(std::string_view source) const
+	{
+		return ScriptAction<R(P...)>{ impl::Compile<R, P...>(primitives, source, false) };
+	}
+
+	template <typename R, typename ... P>
+	ScriptDecision<R(P...)> Registry<R(P...)>::ParseDecision(std::string_view source) const
+	{
+		return ScriptDecision<R(P...)>{ impl::Compile<R, P...>(primitives, source, true) };
+	}
+
+	//------------------
+	//   ScriptAction
+
+	template <typename R, typename ... P>
+	ScriptAction<R(P...)>::ScriptAction(impl::Program<R, P...> program)
+		: program{ std::move(program) }
+	{}
+
+	template <typename R, typename ... P>
+	auto ScriptAction<R(P...)>::operator()(P ... p)
+	{
+		return program.template Run<false>(p...);
+	}
+
+	//--------------------
+	//   ScriptDecision
+
+	template <typename R, typename ... P>
+	ScriptDecision<R(P...)>::ScriptDecision(impl::Program<R, P...> program)
+		: program{ std::move(program) }
+	{}
+
+	template <typename R, typename ... P>
+	bool ScriptDecision<R(P...)>::operator()(P ... p)
+	{
+		return program.template Run<true>(p...);
+	}
+
+}
\ No newline at end of file
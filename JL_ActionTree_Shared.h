@@ -0,0 +1,454 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Switch.h"
+#include "JL_ActionTree_Parallel.h"
+#include "JL_ActionTree_Memo.h"
+#include "JL_ActionTree_Adaptive.h"
+#include "JL_ActionTree_Hint.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace JL::action_tree
+{
+
+	template <typename N>
+	class SharedTree;
+
+	template <typename N>
+	class InstanceStates;
+
+	namespace impl
+	{
+
+		// Sets the instance whose state the nodes use, for as long as it lives
+		class InstanceScope
+		{
+		public:
+
+			InstanceScope(bool* states, size_t instances, size_t instance) noexcept;
+			~InstanceScope();
+
+			InstanceScope(InstanceScope const&) = delete;
+			InstanceScope& operator = (InstanceScope const&) = delete;
+
+		private:
+
+			InstanceSlots        slots;
+			InstanceSlots const* outer;
+		};
+
+		template <typename>
+		constexpr bool is_edge_v = false;
+
+		template <typename D, typename A, bool Rising>
+		constexpr bool is_edge_v<Edge<D, A, Rising>> = true;
+
+		// Child nodes, as a tuple of references. Nodes that are not listed have none.
+		template <typename N>
+		std::tuple<> NodeChildren(N&);
+
+		template <typename F>
+		auto NodeChildren(Action<F>&);
+		template <typename F>
+		auto NodeChildren(Decision<F>&);
+		template <typename D>
+		auto NodeChildren(Not<D>&);
+		template <typename A, typename B>
+		auto NodeChildren(Or<A, B>&);
+		template <typename A, typename B>
+		auto NodeChildren(And<A, B>&);
+		template <typename D, typename A, bool Rising>
+		auto NodeChildren(Edge<D, A, Rising>&);
+		template <typename D, typename A>
+		auto NodeChildren(Conditional<D, A>&);
+		template <typename D, typename A>
+		auto NodeChildren(Branch<D, A>&);
+		template <typename A, typename ... B>
+		auto NodeChildren(Cascade<A, B...>&);
+		template <typename ... A>
+		auto NodeChildren(Sequence<A...>&);
+		template <typename A, typename V>
+		auto NodeChildren(Visit<A, V>&);
+		template <typename K, typename A, typename ... C>
+		auto NodeChildren(SwitchDispatch<K, A, C...>&);
+		template <typename ... A>
+		auto NodeChildren(ParallelSequence<A...>&);
+		template <typename D>
+		auto NodeChildren(Memoized<D>&);
+		template <typename A>
+		auto NodeChildren(MemoScope<A>&);
+		template <bool All, typename ... D>
+		auto NodeChildren(AdaptiveGroup<All, D...>&);
+		template <typename D, int L>
+		auto NodeChildren(Hinted<D, L>&);
+
+		// Nodes with a state of their own, besides that of their children
+		template <typename N, typename ... P>
+		struct KeepsState : std::false_type {};
+
+		template <typename D, typename ... P>
+		struct KeepsState<Memoized<D>, P...> : std::true_type {};
+		template <bool All, typename ... D, typename ... P>
+		struct KeepsState<AdaptiveGroup<All, D...>, P...> : std::true_type {};
+		template <typename A, typename V, typename ... P>
+		struct KeepsState<Visit<A, V>, P...> : std::negation<std::is_invocable<V const&, std::invoke_result_t<A&, P...>>> {};
+
+		// The only state in the tree is that of its edges, which is kept per instance
+		template <typename N, typename ... P>
+		constexpr bool InstanceSafe();
+
+		// Edges in the tree, in the order AssignSlots numbers them
+		template <typename N>
+		constexpr size_t SlotCount();
+
+		template <typename N, size_t S>
+		void AssignSlots(N&, uint32_t& next, std::array<bool, S>& initial);
+
+	}
+
+	// One tree for any number of instances. The tree holds no state of its own anymore: the state of its edges
+	// is kept per instance in InstanceStates, one column per edge, so a thousand instances do not need a thousand trees.
+	// Any other state would be shared by every instance and does not compile: memos, adaptive groups, resumable nodes,
+	// mutable leaves, and firewalls, dynamic actions and hot swaps, whose subtree is not part of the tree type.
+	template <typename T>
+	auto /*SharedTree*/ Share(Action<T>);
+
+	template <typename T>
+	auto /*SharedTree*/ Share(Decision<T>);
+
+	template <typename N>
+	class SharedTree
+	{
+	public:
+
+		// Nodes with a state, known at compile time
+		static constexpr size_t slots = impl::SlotCount<N>();
+
+		explicit SharedTree(N);
+
+		// States for this many instances, each as the tree was when it was shared
+		InstanceStates<N> States(size_t instances) const;
+
+		// Runs the tree for one instance
+		template <typename ... P>
+		decltype(auto) operator () (InstanceStates<N>&, size_t instance, P&& ...);
+
+	private:
+
+		N                       node;
+		std::array<bool, slots> initial{};
+	};
+
+	// State of every instance of a shared tree, struct of arrays: one contiguous column per node.
+	// Different instances may run on different threads at the same time.
+	template <typename N>
+	class InstanceStates
+	{
+	public:
+
+		static constexpr size_t slots = impl::SlotCount<N>();
+
+		InstanceStates(size_t instances, std::array<bool, slots> const& initial);
+
+		size_t Size() const noexcept { return instances; }
+
+		// Keeps the state of the instances that remain, new instances start as the tree was
+		void Resize(size_t);
+
+		// Back to how the tree was
+		void Reset(size_t instance) noexcept;
+
+		// The state of one node, for every instance
+		bool*       Column(size_t slot)       noexcept { return states.get() + slot * instances; }
+		bool const* Column(size_t slot) const noexcept { return states.get() + slot * instances; }
+
+	private:
+
+		friend class SharedTree<N>;
+
+		std::unique_ptr<bool[]> states;
+		size_t                  instances;
+		std::array<bool, slots> initial;
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	//-------------------
+	//   InstanceScope
+
+	inline InstanceScope::InstanceScope(bool* states, size_t instances, size_t instance) noexcept
+		: slots{ states + instance, instances }
+		, outer{ InstanceSlots::current }
+	{
+		InstanceSlots::current = &slots;
+	}
+
+	inline InstanceScope::~InstanceScope()
+	{
+		InstanceSlots::current = outer;
+	}
+
+	//------------------
+	//   NodeChildren
+
+	template <typename N>
+	std::tuple<> NodeChildren(N&)
+	{
+		return {};
+	}
+
+	template <typename F>
+	auto NodeChildren(Action<F>& node)
+	{
+		return std::tie(static_cast<F&>(node));
+	}
+
+	template <typename F>
+	auto NodeChildren(Decision<F>& node)
+	{
+		return std::tie(static_cast<F&>(node));
+	}
+
+	template <typename D>
+	auto NodeChildren(Not<D>& node)
+	{
+		return std::tie(node.decision);
+	}
+
+	template <typename A, typename B>
+	auto NodeChildren(Or<A, B>& node)
+	{
+		return std::tie(node.a, node.b);
+	}
+
+	template <typename A, typename B>
+	auto NodeChildren(And<A, B>& node)
+	{
+		return std::tie(node.a, node.b);
+	}
+
+	template <typename D, typename A, bool Rising>
+	auto NodeChildren(Edge<D, A, Rising>& node)
+	{
+		return std::tie(node.decision, node.action);
+	}
+
+	template <typename D, typename A>
+	auto NodeChildren(Conditional<D, A>& node)
+	{
+		return std::tie(node.decision, node.action);
+	}
+
+	template <typename D, typename A>
+	auto NodeChildren(Branch<D, A>& node)
+	{
+		return std::tie(node.decision, node.action);
+	}
+
+	template <typename A, typename ... B>
+	auto NodeChildren(Cascade<A, B...>& node)
+	{
+		return std::tuple_cat(std::apply([](auto& ... b) { return std::tie(b...); }, node.branches), std::tie(node.fallback));
+	}
+
+	template <typename ... A>
+	auto NodeChildren(Sequence<A...>& node)
+	{
+		return std::apply([](auto& ... a) { return std::tie(a...); }, node.actions);
+	}
+
+	template <typename A, typename V>
+	auto NodeChildren(Visit<A, V>& node)
+	{
+		return std::tie(node.action);
+	}
+
+	template <typename K, typename A, typename ... C>
+	auto NodeChildren(SwitchDispatch<K, A, C...>& node)
+	{
+		return std::tuple_cat(
+			std::tie(node.key),
+			std::apply([](auto& ... c) { return std::tie(c.action...); }, node.cases),
+			std::tie(node.fallback)
+		);
+	}
+
+	template <typename ... A>
+	auto NodeChildren(ParallelSequence<A...>& node)
+	{
+		return std::apply([](auto& ... a) { return std::tie(a...); }, node.actions);
+	}
+
+	template <typename D>
+	auto NodeChildren(Memoized<D>& node)
+	{
+		return std::tie(node.decision);
+	}
+
+	template <typename A>
+	auto NodeChildren(MemoScope<A>& node)
+	{
+		return std::tie(node.action);
+	}
+
+	template <bool All, typename ... D>
+	auto NodeChildren(AdaptiveGroup<All, D...>& node)
+	{
+		return std::apply([](auto& ... d) { return std::tie(d...); }, node.operands);
+	}
+
+	template <typename D, int L>
+	auto NodeChildren(Hinted<D, L>& node)
+	{
+		return std::tie(node.decision);
+	}
+
+	//-----------------
+	//   InstanceSafe
+
+	template <typename Children, typename ... P>
+	struct ChildrenInstanceSafe;
+
+	template <typename ... C, typename ... P>
+	struct ChildrenInstanceSafe<std::tuple<C&...>, P...> : std::bool_constant<(InstanceSafe<C, P...>() && ...)> {};
+
+	template <typename N, typename ... P>
+	constexpr bool InstanceSafe()
+	{
+		using Children = decltype(NodeChildren(std::declval<N&>()));
+		if constexpr (Stateless<N, P...>::value)
+			return true;
+		else
+		if constexpr (KeepsState<N, P...>::value)
+			return false;
+		else
+		if constexpr (std::tuple_size_v<Children> == 0)
+			return false;	// a leaf that remembers, or a node that hides its subtree
+		else
+			return ChildrenInstanceSafe<Children, P...>::value;
+	}
+
+	//-----------
+	//   Slots
+
+	template <typename Children>
+	struct ChildSlots;
+
+	template <typename ... C>
+	struct ChildSlots<std::tuple<C&...>>
+	{
+		static constexpr size_t value = (size_t{} + ... + SlotCount<C>());
+	};
+
+	template <typename N>
+	constexpr size_t SlotCount()
+	{
+		return size_t{ is_edge_v<N> } + ChildSlots<decltype(NodeChildren(std::declval<N&>()))>::value;
+	}
+
+	template <typename N, size_t S>
+	void AssignSlots(N& node, uint32_t& next, std::array<bool, S>& initial)
+	{
+		if constexpr (is_edge_v<N>)
+		{
+			initial[next] = node.on;
+			node.slot     = next++;
+		}
+		std::apply([&](auto& ... child) { (AssignSlots(child, next, initial), ...); }, NodeChildren(node));
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	//----------------
+	//   SharedTree
+
+	template <typename N>
+	SharedTree<N>::SharedTree(N node)
+		: node{ std::move(node) }
+	{
+		uint32_t next{};
+		impl::AssignSlots(this->node, next, initial);
+	}
+
+	template <typename N>
+	InstanceStates<N> SharedTree<N>::States(size_t instances) const
+	{
+		return InstanceStates<N>{ instances, initial };
+	}
+
+	template <typename N>
+	template <typename ... P>
+	decltype(auto) SharedTree<N>::operator()(InstanceStates<N>& states, size_t instance, P&& ... p)
+	{
+		static_assert(impl::InstanceSafe<N, P...>(), "SharedTree  The tree keeps state that is not per instance: a memo, adaptive group, resumable node, mutable leaf, or a firewall, dynamic action or hot swap. Only the state of edges is kept per instance.");
+		impl::InstanceScope scope{ states.states.get(), states.instances, instance };
+		return node(std::forward<P>(p)...);
+	}
+
+	template <typename T>
+	auto Share(Action<T> action)
+	{
+		return SharedTree<Action<T>>{ std::move(action) };
+	}
+
+	template <typename T>
+	auto Share(Decision<T> decision)
+	{
+		return SharedTree<Decision<T>>{ std::move(decision) };
+	}
+
+	//--------------------
+	//   InstanceStates
+
+	template <typename N>
+	InstanceStates<N>::InstanceStates(size_t instances, std::array<bool, slots> const& initial)
+		: states{ new bool[slots * instances] }
+		, instances{ instances }
+		, initial{ initial }
+	{
+		for (size_t s{}; s < slots; ++s)
+			std::fill_n(Column(s), instances, initial[s]);
+	}
+
+	template <typename N>
+	void InstanceStates<N>::Resize(size_t count)
+	{
+		InstanceStates resized{ count, initial };
+		for (size_t s{}; s < slots; ++s)
+			std::copy_n(Column(s), std::min(count, instances), resized.Column(s));
+		*this = std::move(resized);
+	}
+
+	template <typename N>
+	void InstanceStates<N>::Reset(size_t instance) noexcept
+	{
+		for (size_t s{}; s < slots; ++s)
+			Column(s)[instance] = initial[s];
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,582 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Branch.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		template <auto First, auto Last, typename A>
+		struct Case
+		{
+			static constexpr auto first = First;
+			static constexpr auto last  = Last;
+
+			A action;
+		};
+
+		// Switch || a
+		template <typename K, typename A, typename ... C>
+		struct SwitchDispatch
+		{
+			Action<K>        key;
+			std::tuple<C...> cases;
+			A                fallback;
+
+			template <typename ... P>
+			auto operator () (P&& ...);
+			template <typename ... P>
+			auto operator () (P&& ...) const;
+		};
+
+		template <auto First, auto Last, typename A, typename ... P>
+		struct Stateless<Case<First, Last, A>, P...> : Stateless<A, P...> {};
+
+		template <typename K, typename A, typename ... C, typename ... P>
+		struct Stateless<SwitchDispatch<K, A, C...>, P...> : std::conjunction<Stateless<Action<K>, P...>, Stateless<C, P...>..., Stateless<A, P...>> {};
+
+	}
+
+	// Keyed series of branches, the key is looked up in a jump table instead of testing each case in turn.
+	template <typename K, typename ... C>
+	struct Switch
+	{
+		Action<K>        key;
+		std::tuple<C...> cases;
+
+		constexpr explicit Switch(Action<K>, C...);
+
+		TEMPLATE  /* Action */ operator || (Action<T>) const&;
+		TEMPLATE  /* Action */ operator || (Action<T>) &&;
+	};
+
+	template <typename K, typename ... C>
+	Switch(Action<K>, C...)->Switch<K, C...>;
+
+	template <auto Key, typename T>
+	constexpr auto /* Case */ on(Action<T>);
+
+	template <auto First, auto Last, typename T>
+	constexpr auto /* Case */ on(Action<T>);
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	template <typename T>
+	constexpr std::int64_t SwitchKey(T key)
+	{
+		if constexpr (std::is_enum_v<T>)
+			return static_cast<std::int64_t>(static_cast<std::underlying_type_t<T>>(key));
+		else
+			return static_cast<std::int64_t>(key);
+	}
+
+	// Binary heap on the first `size` elements, the greatest by `less` on top
+	template <typename T, size_t N, typename L>
+	constexpr void HeapDown(std::array<T, N>& heap, size_t size, size_t i, L less)
+	{
+		for (size_t child; (child = 2 * i + 1) < size; i = child)
+		{
+			if (child + 1 < size && less(heap[child], heap[child + 1]))
+				++child;
+			if (!less(heap[i], heap[child]))
+				return;
+			T const swap{ heap[i] };
+			heap[i]     = heap[child];
+			heap[child] = swap;
+		}
+	}
+
+	template <typename T, size_t N, typename L>
+	constexpr void HeapUp(std::array<T, N>& heap, size_t i, L less)
+	{
+		for (size_t parent; i && less(heap[parent = (i - 1) / 2], heap[i]); i = parent)
+		{
+			T const swap{ heap[i] };
+			heap[i]      = heap[parent];
+			heap[parent] = swap;
+		}
+	}
+
+	// std::sort is constexpr from C++20 on
+	template <typename T, size_t N, typename L>
+	constexpr void HeapSort(std::array<T, N>& data, size_t size, L less)
+	{
+		for (size_t i{ size / 2 }; i-- > 0;)
+			HeapDown(data, size, i, less);
+		for (size_t end{ size }; end > 1;)
+		{
+			T const swap{ data[0] };
+			data[0]     = data[--end];
+			data[end]   = swap;
+			HeapDown(data, end, 0, less);
+		}
+	}
+
+	// splitmix64 finaliser
+	constexpr std::uint64_t SwitchMix(std::uint64_t z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// Maps every key to the index of its case, sizeof...(C) for the fallback. Cases are kept as intervals,
+	// a key that appears twice belongs to its first case.
+	//   dense    index[key - min]
+	//   sparse   single keys and short ranges through a perfect hash (hash and displace), wide ranges in a sorted table
+	//   sorted   every interval in a sorted table, when no perfect hash is found
+	template <typename ... C>
+	struct SwitchTable
+	{
+		static constexpr size_t fallback = sizeof...(C);
+		static constexpr size_t cases    = sizeof...(C);
+
+		// Ranges up to this many keys are hashed key by key
+		static constexpr std::uint64_t short_range = 4;
+
+		struct Segment
+		{
+			std::int64_t first;
+			std::int64_t last;
+			size_t       index;
+		};
+
+		struct Segments
+		{
+			std::array<Segment, 2 * cases> data{};
+			size_t size{};
+		};
+
+		// Disjoint intervals in order of their keys. Every one starts where a case starts or where one ends,
+		// so there are at most twice as many as there are cases.
+		static constexpr Segments segments = []
+		{
+			Segments out{};
+			if constexpr (cases != 0)
+			{
+				std::array<Segment, cases> in{ Segment{ SwitchKey(C::first), SwitchKey(C::last), 0 }... };
+				for (size_t c{}; c < cases; ++c)
+					in[c].index = c;
+				HeapSort(in, cases, [](Segment const& a, Segment const& b) { return a.first < b.first || (a.first == b.first && a.index < b.index); });
+
+				// The cases that cover the current key, the first of them on top
+				auto const later = [](Segment const& a, Segment const& b) { return a.index > b.index; };
+				std::array<Segment, cases> covering{};
+				size_t covered{};
+
+				size_t next{};
+				std::int64_t key{};
+				while (next < cases || covered != 0)
+				{
+					if (covered == 0)
+						key = in[next].first;
+					for (; next < cases && in[next].first == key; ++next)
+					{
+						covering[covered] = in[next];
+						HeapUp(covering, covered++, later);
+					}
+					while (covered != 0 && covering[0].last < key)
+					{
+						covering[0] = covering[--covered];
+						HeapDown(covering, covered, 0, later);
+					}
+					if (covered == 0)
+						continue;
+
+					// Up to the end of the first case, or to where the next one starts
+					Segment const top{ covering[0] };
+					std::int64_t last{ top.last };
+					if (next < cases && in[next].first - 1 < last)
+						last = in[next].first - 1;
+
+					if (out.size != 0 && out.data[out.size - 1].index == top.index && out.data[out.size - 1].last == key - 1)
+						out.data[out.size - 1].last = last;
+					else
+						out.data[out.size++] = { key, last, top.index };
+
+					if (last == std::numeric_limits<std::int64_t>::max())
+						break;
+					key = last + 1;
+				}
+			}
+			return out;
+		}();
+
+		static constexpr std::int64_t min = segments.size != 0 ? segments.data[0].first : 0;
+		static constexpr std::int64_t max = segments.size != 0 ? segments.data[segments.size - 1].last : 0;
+
+		static constexpr std::uint64_t Length(Segment const& segment)
+		{
+			return std::uint64_t(segment.last) - std::uint64_t(segment.first) + 1;
+		}
+
+		static constexpr std::uint64_t range = std::uint64_t(max) - std::uint64_t(min) + 1;
+		static constexpr std::uint64_t keys  = []
+		{
+			std::uint64_t out{};
+			for (size_t i{}; i < segments.size; ++i)
+				out += Length(segments.data[i]);
+			return out;
+		}();
+
+		static constexpr bool dense = range != 0 && range <= 4096 && range <= 2 * keys + 16;
+
+		// Sparse: keys of short segments, hashed
+
+		struct Point
+		{
+			std::int64_t  key;
+			std::uint16_t index;
+		};
+
+		static constexpr size_t point_count = []
+		{
+			size_t out{};
+			for (size_t i{}; !dense && i < segments.size; ++i)
+				if (Length(segments.data[i]) <= short_range)
+					out += size_t(Length(segments.data[i]));
+			return out;
+		}();
+
+		static constexpr std::array<Point, point_count> points = []
+		{
+			std::array<Point, point_count> out{};
+			size_t size{};
+			for (size_t i{}; !dense && i < segments.size; ++i)
+				if (Length(segments.data[i]) <= short_range)
+					for (std::int64_t key{ segments.data[i].first }; size < point_count; ++key)
+					{
+						out[size++] = { key, std::uint16_t(segments.data[i].index) };
+						if (key == segments.data[i].last)
+							break;
+					}
+			return out;
+		}();
+
+		// A bucket per four keys, every bucket has a displacement that moves its keys to free slots
+		static constexpr unsigned bucket_bits = []
+		{
+			unsigned bits{ 1 };
+			while ((size_t(1) << bits) * 4 < point_count)
+				++bits;
+			return bits;
+		}();
+
+		static constexpr size_t buckets = size_t(1) << bucket_bits;
+
+		// At least a fifth of the slots are free
+		static constexpr unsigned slot_bits = []
+		{
+			unsigned bits{ 1 };
+			while ((size_t(1) << bits) < point_count + point_count / 4)
+				++bits;
+			return bits;
+		}();
+
+		struct Hash
+		{
+			std::uint64_t seed;
+			unsigned      bits;
+			bool          found;
+
+			constexpr size_t Bucket(std::int64_t key) const
+			{
+				return size_t(SwitchMix(std::uint64_t(key) + seed) >> (64 - bucket_bits));
+			}
+
+			constexpr size_t Slot(std::int64_t key, std::uint64_t displace) const
+			{
+				return size_t(SwitchMix(std::uint64_t(key) ^ displace) >> (64 - bits));
+			}
+		};
+
+		template <size_t S>
+		struct Layout
+		{
+			std::array<std::uint64_t, buckets> displace{};
+			std::array<std::int64_t, S>        key{};
+			std::array<std::uint16_t, S>       index{};
+		};
+
+		// Largest buckets first, then for every bucket the first displacement that puts its keys in free slots
+		template <size_t S>
+		static constexpr bool Place(Hash const& hash, Layout<S>& out)
+		{
+			std::array<size_t, buckets + 1> start{};
+			for (size_t i{}; i < point_count; ++i)
+				++start[hash.Bucket(points[i].key) + 1];
+			for (size_t b{}; b < buckets; ++b)
+				start[b + 1] += start[b];
+
+			std::array<size_t, buckets> fill{};
+			std::array<std::int64_t, point_count + 1> grouped{};
+			std::array<std::uint16_t, point_count + 1> index{};
+			for (size_t i{}; i < point_count; ++i)
+			{
+				size_t const b{ hash.Bucket(points[i].key) };
+				grouped[start[b] + fill[b]] = points[i].key;
+				index  [start[b] + fill[b]] = points[i].index;
+				++fill[b];
+			}
+
+			std::array<size_t, buckets> order{};
+			for (size_t b{}; b < buckets; ++b)
+				order[b] = b;
+			HeapSort(order, buckets, [&start](size_t a, size_t b) { return start[a + 1] - start[a] > start[b + 1] - start[b]; });
+
+			std::array<bool, S> used{};
+			for (size_t o{}; o < buckets; ++o)
+			{
+				size_t const b{ order[o] };
+				if (start[b] == start[b + 1])
+					break;
+
+				bool placed{};
+				for (std::uint64_t attempt{}; !placed && attempt < 1024; ++attempt)
+				{
+					std::uint64_t const displace{ hash.seed ^ ((attempt + 1) * 0x9E3779B97F4A7C15ull) };
+					placed = true;
+					for (size_t i{ start[b] }; placed && i < start[b + 1]; ++i)
+					{
+						size_t const slot{ hash.Slot(grouped[i], displace) };
+						placed = !used[slot];
+						for (size_t j{ start[b] }; placed && j < i; ++j)
+							placed = hash.Slot(grouped[j], displace) != slot;
+					}
+					if (placed)
+					{
+						out.displace[b] = displace;
+						for (size_t i{ start[b] }; i < start[b + 1]; ++i)
+						{
+							size_t const slot{ hash.Slot(grouped[i], displace) };
+							used     [slot] = true;
+							out.key  [slot] = grouped[i];
+							out.index[slot] = index[i];
+						}
+					}
+				}
+				if (!placed)
+					return false;
+			}
+
+			// Empty slots lead to the fallback, whatever key they hold
+			for (size_t slot{}; slot < S; ++slot)
+				if (!used[slot])
+					out.index[slot] = std::uint16_t(fallback);
+			return true;
+		}
+
+		// A few seeds at two table sizes, before giving up on hashing
+		static constexpr Hash hash = []
+		{
+			if (dense || point_count == 0)
+				return Hash{};
+			for (unsigned bits{ slot_bits }; bits <= slot_bits + 1; ++bits)
+				for (std::uint64_t seed{}; seed < 4; ++seed)
+				{
+					Hash const candidate{ SwitchMix(seed + 1), bits, true };
+					Layout<size_t(1) << (slot_bits + 1)> layout{};
+					if (Place(candidate, layout))
+						return candidate;
+				}
+			return Hash{};
+		}();
+
+		static constexpr size_t slots = dense ? size_t(range) : hash.found ? size_t(1) << hash.bits : 0;
+
+		static constexpr Layout<slots> table = []
+		{
+			Layout<slots> out{};
+			if (dense)
+			{
+				for (size_t s{}; s < slots; ++s)
+					out.index[s] = std::uint16_t(fallback);
+				for (size_t i{}; i < segments.size; ++i)
+					for (size_t s{ size_t(segments.data[i].first - min) }; s <= size_t(segments.data[i].last - min); ++s)
+						out.index[s] = std::uint16_t(segments.data[i].index);
+			}
+			else
+			if (hash.found)
+				Place(hash, out);
+			return out;
+		}();
+
+		// Sparse: wide segments, or all of them without a hash
+
+		static constexpr bool Sorted(Segment const& segment)
+		{
+			return !dense && (!hash.found || Length(segment) > short_range);
+		}
+
+		static constexpr size_t sorted_count = []
+		{
+			size_t out{};
+			for (size_t i{}; i < segments.size; ++i)
+				out += Sorted(segments.data[i]);
+			return out;
+		}();
+
+		static constexpr std::array<Segment, sorted_count> sorted = []
+		{
+			std::array<Segment, sorted_count> out{};
+			size_t size{};
+			for (size_t i{}; i < segments.size; ++i)
+				if (Sorted(segments.data[i]))
+					out[size++] = segments.data[i];
+			return out;
+		}();
+
+		static size_t Search(std::int64_t key)
+		{
+			size_t low{}, high{ sorted_count };
+			while (low < high)
+			{
+				size_t const middle{ low + (high - low) / 2 };
+				if (sorted[middle].first <= key)
+					low = middle + 1;
+				else
+					high = middle;
+			}
+			return low != 0 && key <= sorted[low - 1].last ? sorted[low - 1].index : fallback;
+		}
+
+		static size_t Find(std::int64_t key)
+		{
+			if constexpr (dense)
+			{
+				std::uint64_t const slot = std::uint64_t(key) - std::uint64_t(min);
+				return slot < range ? table.index[slot] : fallback;
+			}
+			else
+			{
+				if constexpr (slots != 0)
+				{
+					size_t const slot = hash.Slot(key, table.displace[hash.Bucket(key)]);
+					if (table.key[slot] == key && table.index[slot] != fallback)
+						return table.index[slot];
+				}
+				if constexpr (sorted_count != 0)
+					return Search(key);
+				else
+					return fallback;
+			}
+		}
+	};
+
+	template <typename R, size_t I, typename Cases, typename A, typename ... P>
+	R RunCase(Cases& cases, A& fallback, P&& ... p)
+	{
+		if constexpr (I == std::tuple_size_v<Cases>)
+			return RunInto<R>(fallback, std::forward<P>(p)...);
+		else
+			return RunInto<R>(std::get<I>(cases).action, std::forward<P>(p)...);
+	}
+
+	// One indirect jump to the case, or to the fallback
+	template <typename R, typename Cases, typename A, size_t ... I, typename ... P>
+	R RunSwitch(size_t index, Cases& cases, A& fallback, std::index_sequence<I...>, P&& ... p)
+	{
+		using Jump = R(*)(Cases&, A&, P&& ...);
+		static constexpr Jump jump[]{ &RunCase<R, I, Cases, A, P...>... };
+		return jump[index](cases, fallback, std::forward<P>(p)...);
+	}
+
+	template <typename K, typename A, typename ... C>
+	template <typename ... P>
+	auto SwitchDispatch<K, A, C...>::operator()(P&& ... p)
+	{
+		if constexpr (is_awaitable_v<decltype(key(p...)), decltype(std::declval<C&>().action(p...))..., decltype(fallback(p...))>)
+			return RunAsync(*this, Capture(std::forward<P>(p)...));
+		else
+		{
+			using R     = StackResult_t<decltype(std::declval<C&>().action(p...))..., decltype(fallback(p...))>;
+			using Table = SwitchTable<C...>;
+
+			return RunSwitch<R>(
+				Table::Find(SwitchKey(key(p...))),
+				cases, fallback,
+				std::index_sequence_for<C..., A>{},
+				std::forward<P>(p)...
+			);
+		}
+	}
+
+	template <typename K, typename A, typename ... C>
+	template <typename ... P>
+	auto SwitchDispatch<K, A, C...>::operator()(P&& ... p) const
+	{
+		RequireStateless<P...>(*this);
+		using R     = StackResult_t<decltype(std::declval<C const&>().action(p...))..., decltype(fallback(p...))>;
+		using Table = SwitchTable<C...>;
+
+		return RunSwitch<R>(
+			Table::Find(SwitchKey(key(p...))),
+			cases, fallback,
+			std::index_sequence_for<C..., A>{},
+			std::forward<P>(p)...
+		);
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename _K, typename ... _C>
+	constexpr Switch<_K, _C...>::Switch(Action<_K> key, _C ... cases)
+		: key{ std::move(key) }
+		, cases{ std::move(cases)... }
+	{}
+
+	template <typename _K, typename ... _C>
+	template <typename T>
+	constexpr auto Switch<_K, _C...>::operator||(Action<T> action) const&
+	{
+		return Switch<_K, _C...>(*this) || std::move(action);
+	}
+
+	template <typename _K, typename ... _C>
+	template <typename T>
+	constexpr auto Switch<_K, _C...>::operator||(Action<T> action) &&
+	{
+		using SwitchDispatch = impl::SwitchDispatch<_K, Action<T>, _C...>;
+		return Action<SwitchDispatch>{ SwitchDispatch{ std::move(key), std::move(cases), std::move(action) } };
+	}
+
+	template <auto Key, typename T>
+	constexpr auto on(Action<T> action)
+	{
+		return impl::Case<Key, Key, Action<T>>{ std::move(action) };
+	}
+
+	template <auto First, auto Last, typename T>
+	constexpr auto on(Action<T> action)
+	{
+		static_assert(impl::SwitchKey(First) <= impl::SwitchKey(Last), "on<First, Last>(Action)  First must not be greater than Last.");
+		return impl::Case<First, Last, Action<T>>{ std::move(action) };
+	}
+
+}
@@ -9,10 +9,26 @@
 #pragma once
 
 #include "JL_ActionTree.h"
+#include "JL_ActionTree_Profile.h"
 using namespace JL::action_tree;
 
 #include "JL_Visitor.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if __has_include(<span>)
+#include <span>
+#endif
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
 #define CATCH_CONFIG_MAIN
 #include "../catch2/catch.hpp"
 
@@ -34,6 +50,54 @@ struct NonDefault : Value
 	NonDefault(int i) : Value{ i } {}
 };
 
+struct Counted
+{
+	static inline int copies{}, moves{};
+
+	Counted() = default;
+	Counted(Counted const&) { ++copies; }
+	Counted(Counted&&) noexcept { ++moves; }
+	Counted& operator = (Counted const&) { ++copies; return *this; }
+	Counted& operator = (Counted&&) noexcept { ++moves; return *this; }
+
+	static void reset() { copies = moves = 0; }
+};
+
+template <typename T>
+struct Part : Counted
+{
+	T value;
+};
+
+// Stand-in for std::expected<T, E>, which is C++23
+template <typename E>
+struct Failure
+{
+	E error;
+};
+
+template <typename T, typename E>
+struct Outcome
+{
+	using value_type      = T;
+	using error_type      = E;
+	using unexpected_type = Failure<E>;
+	using Stored          = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+	std::variant<Stored, Failure<E>> state{};
+
+	Outcome() = default;
+	template <typename V, typename = std::enable_if_t<std::is_convertible_v<V, Stored>>>
+	Outcome(V&& value) : state{ std::in_place_index<0>, std::forward<V>(value) } {}
+	Outcome(Failure<E> failure) : state{ std::in_place_index<1>, std::move(failure) } {}
+
+	bool          has_value()  const  { return state.index() == 0; }
+	Stored const& operator * () const& { return std::get<0>(state); }
+	Stored&&      operator * () &&     { return std::get<0>(std::move(state)); }
+	E const&      error()      const& { return std::get<1>(state).error; }
+	E&&           error()      &&     { return std::get<1>(std::move(state)).error; }
+};
+
 Action makeNothing   { [](auto){} };
 Action makeValue     { [](int i) -> Value      { return {1 * i}; } };
 Action makeAddable   { [](int i) -> Addable    { return {2 * i}; } };
@@ -90,7 +154,7 @@ TEST_CASE("Test Action")
 		auto values = makeValue   | makeValueAlt;
 		auto added  = makeAddable | makeAddableAlt;
 
-		using Paired = std::pair<Value, Value>;
+		using Paired = std::tuple<Value, Value>;
 		REQUIRE_TYPE(Paired , values(0));
 		REQUIRE_TYPE(Addable, added (0));
 
@@ -102,6 +166,32 @@ TEST_CASE("Test Action")
 
 	}
 
+	{
+
+		// Test flattened sequence
+
+		auto flat   = makeValue | makeNothing | makeAddable | makeNothing | makeNonDefault;
+		auto summed = makeAddable | makeAddableAlt | makeValue;
+		auto nested = makeValue | (makeAddable | makeAddableAlt);
+
+		using Flat   = std::tuple<Value, Addable, NonDefault>;
+		using Summed = std::tuple<Addable, Value>;
+		using Nested = std::tuple<Value, Addable>;
+		REQUIRE_TYPE(Flat  , flat  (0));
+		REQUIRE_TYPE(Summed, summed(0));
+		REQUIRE_TYPE(Nested, nested(0));
+
+		auto [f1, f2, f3] = flat(7);
+		REQUIRE(f1.value == 7);
+		REQUIRE(f2.value == 7 * 2);
+		REQUIRE(f3.value == 7 * 7);
+
+		auto [s1, s2] = summed(7);
+		REQUIRE(s1.value == (7 * 2) + (7 * 5));
+		REQUIRE(s2.value == 7);
+
+	}
+
 	{
 
 		// Test visitor
@@ -120,6 +210,41 @@ TEST_CASE("Test Action")
 
 }
 
+TEST_CASE("Test sequence against hand-written struct")
+{
+
+	auto part = [](auto value) { return Action{ [value](int) { return Part<decltype(value)>{ {}, value }; } }; };
+
+	auto sequence = part('a') | part(1.0) | part(2) | part('b') | part(short(3)) | part(4.0) | part(true) | part(5);
+
+	struct HandWritten
+	{
+		Part<char> a; Part<double> b; Part<int> c; Part<char> d; Part<short> e; Part<double> f; Part<bool> g; Part<int> h;
+	};
+
+	// Every stage runs to completion before the next one starts, and the results are gathered at the end
+	auto handWritten = [](int)
+	{
+		auto a = Part<char>{ {}, 'a' }; auto b = Part<double>{ {}, 1.0 }; auto c = Part<int>{ {}, 2 }; auto d = Part<char>{ {}, 'b' };
+		auto e = Part<short>{ {}, 3 };  auto f = Part<double>{ {}, 4.0 }; auto g = Part<bool>{ {}, true }; auto h = Part<int>{ {}, 5 };
+		return HandWritten{ std::move(a), std::move(b), std::move(c), std::move(d), std::move(e), std::move(f), std::move(g), std::move(h) };
+	};
+
+	REQUIRE(sizeof(sequence(0)) == sizeof(HandWritten));
+
+	Counted::reset();
+	auto result = sequence(0);
+	auto const moves = Counted::moves;
+
+	Counted::reset();
+	auto expected = handWritten(0);
+
+	REQUIRE(moves == Counted::moves);
+	REQUIRE(Counted::copies == 0);
+	REQUIRE(std::get<7>(result).value == expected.h.value);
+
+}
+
 TEST_CASE("Test Decision")
 {
 
@@ -288,39 +413,2215 @@ TEST_CASE("Test branch stack")
 
 		auto stack = select(0) && makeValue || select(1) && makeAddable || makeNonDefault;
 
-		using Pair = impl::Either<Value, impl::Either<Addable, NonDefault>>;
-		REQUIRE_TYPE(Pair, stack(0));
-		
+		using Flat = std::variant<Value, Addable, NonDefault>;
+		REQUIRE_TYPE(Flat, stack(0));
+
+		REQUIRE(stack(0).index() == 0);
+		REQUIRE(stack(1).index() == 1);
+		REQUIRE(stack(2).index() == 2);
+		REQUIRE(std::get<2>(stack(2)).value == 2 * 7);
+
+	}
+
+	{
+
+		// Duplicate and void return types
+
+		auto stack = select(0) && makeValue || select(1) && makeNothing || select(2) && makeValue || makeAddable;
+		auto maybe = select(0) && makeValue || select(1) && makeNothing || makeValue;
+
+		using Flat  = std::variant<Value, std::monostate, Addable>;
+		using Maybe = impl::Maybe<Value>;
+		REQUIRE_TYPE(Flat , stack(0));
+		REQUIRE_TYPE(Maybe, maybe(0));
+
 		REQUIRE(stack(0).index() == 0);
+		REQUIRE(stack(1).index() == 1);
+		REQUIRE(stack(2).index() == 0);
+		REQUIRE(stack(3).index() == 2);
+
+		REQUIRE(maybe(1).has_value() == false);
+		REQUIRE(maybe(2).value().value == 2);
+
+	}
+
+	{
+
+		// Results are moved once into their slot
+
+		auto counted = [] { return Action{ [](int) { return Part<int>{}; } }; };
+		auto stack   = select(0) && counted() || select(1) && makeValue || select(2) && makeAddable || counted();
+
+		Counted::reset();
+		stack(0);
+		stack(3);
+		REQUIRE(Counted::copies == 0);
+		REQUIRE(Counted::moves  == 2);
+
+	}
+
+}
+
+TEST_CASE("Test switch")
+{
+
+	using namespace std::string_view_literals;
+	using sv = std::string_view;
+
+	auto name = [](sv sv) { return Action{ [sv](int) { return sv; } }; };
+	Action key{ [](int i) { return i; } };
+
+	{
+
+		// Dense keys, same as a branch stack
+
+		auto what  = Switch{ key, on<0>(name("a")), on<1>(name("b")), on<3>(name("d")) } || name("c");
+		auto stack = [](int i) { return Decision{ [i](int j) { return i == j; } }; };
+		auto same  = stack(0) && name("a") || stack(1) && name("b") || stack(3) && name("d") || name("c");
+
+		REQUIRE_TYPE(sv, what(0));
+		for (int i{ -2 }; i < 6; ++i)
+			REQUIRE(what(i) == same(i));
+
+	}
+
+	{
+
+		// Sparse keys
+
+		auto what = Switch{ key, on<-1000>(name("a")), on<7>(name("b")), on<123456>(name("c")), on<7>(name("x")) } || name("-");
+
+		REQUIRE(what(-1000)  == "a");
+		REQUIRE(what(7)      == "b");
+		REQUIRE(what(123456) == "c");
+		REQUIRE(what(0)      == "-");
+		REQUIRE(what(8)      == "-");
+
+	}
+
+	{
+
+		// Enum ranges and flat results
+
+		enum class Colour { red, orange, yellow, green, blue, purple };
+
+		Action colour{ [](int i) { return Colour(i); } };
+
+		auto what = Switch{ colour, on<Colour::red, Colour::yellow>(makeValue), on<Colour::green>(makeNothing) } || makeAddable;
+
+		using Flat = std::variant<Value, std::monostate, Addable>;
+		REQUIRE_TYPE(Flat, what(0));
+
+		REQUIRE(what(0).index() == 0);
+		REQUIRE(what(2).index() == 0);
+		REQUIRE(what(3).index() == 1);
+		REQUIRE(what(5).index() == 2);
+		REQUIRE(std::get<0>(what(2)).value == 2);
+
+	}
+
+	{
+
+		// Wide ranges and overlaps, the first case that holds a key takes it
+
+		auto what = Switch{ key, on<100>(name("a")), on<0, 100000>(name("b")), on<-50, 50>(name("c")), on<1 << 30, (1 << 30) + 2>(name("d")) } || name("-");
+
+		REQUIRE(what(100)        == "a");
+		REQUIRE(what(0)          == "b");
+		REQUIRE(what(99)         == "b");
+		REQUIRE(what(101)        == "b");
+		REQUIRE(what(100000)     == "b");
+		REQUIRE(what(-50)        == "c");
+		REQUIRE(what(-1)         == "c");
+		REQUIRE(what(-51)        == "-");
+		REQUIRE(what(100001)     == "-");
+		REQUIRE(what(1 << 30)    == "d");
+		REQUIRE(what((1 << 30) + 3) == "-");
+
+	}
+
+	{
+
+		// Many sparse keys
+
+		constexpr auto sparse = [](size_t i) { return int(impl::SwitchMix(i) >> 40) - (1 << 23); };
+
+		auto what = [&]<size_t ... I>(std::index_sequence<I...>)
+		{
+			return Switch{ key, on<sparse(I)>(Action{ [](int) { return int(I); } })... } || Action{ [](int) { return -1; } };
+		}(std::make_index_sequence<300>{});
+
+		for (size_t i{}; i < 300; ++i)
+			REQUIRE(what(sparse(i)) == int(i));
+		REQUIRE(what(sparse(300)) == -1);
+		REQUIRE(what(0) == -1);
+
+	}
+
+}
+
+TEST_CASE("Test memoized decision")
+{
+
+	int calls{};
+	Decision expensive{ [&calls](int i) { ++calls; return i > 2; } };
+	auto     shared = Memo(expensive);
+
+	// The same decision in several places of one tree
+	auto tree = !shared && makeValue || (shared & isEven) && makeValueAlt || shared + makeNothing && makeAddable || makeNonDefault;
+
+	{
+
+		// Runs once per evaluation
+
+		auto ticked = WithMemo(tree);
+		for (int i{}; i < 6; ++i)
+		{
+			calls = 0;
+			(void)ticked(i);
+			REQUIRE(calls == 1);
+		}
+
+		calls = 0;
+		{
+			MemoContext const tick{};
+			(void)tree(1);
+			(void)tree(1);
+		}
+		REQUIRE(calls == 1);
+
+	}
+
+	{
 
-		if (stack(1).index() != 1 || stack(2).index() != 1)
+		// Other arguments in the same evaluation are results of their own
+
+		calls = 0;
+		{
+			MemoContext const tick{};
+			REQUIRE(!shared(1));
+			REQUIRE(shared(5));
+			REQUIRE(!shared(1));
+			REQUIRE(shared(5));
+			REQUIRE(std::get<Value>(tree(1)).value == 1);
+			REQUIRE(std::get<Value>(tree(4)).value == 12);
+		}
+		REQUIRE(calls == 3);
+
+	}
+
+	{
+
+		// Objects passed by reference are told apart by address, they are not copied or compared
+
+		struct Entity
+		{
+			int health;
+			Entity(int health) : health{ health } {}
+			Entity(Entity const&) = delete;
+		};
+
+		int seen{};
+		auto hurt = Memo(Decision{ [&seen](Entity const& entity) { ++seen; return entity.health < 50; } });
+
+		Entity const weak{ 10 }, strong{ 90 };
+		{
+			MemoContext const tick{};
+			REQUIRE(hurt(weak));
+			REQUIRE(!hurt(strong));
+			REQUIRE(hurt(weak));
+			REQUIRE(!hurt(strong));
+		}
+		REQUIRE(seen == 2);
+
+	}
+
+	{
+
+		// Without an evaluation, or in a new one, it runs again
+
+		calls = 0;
+		(void)tree(3);
+		REQUIRE(calls == 3);
+
+		calls = 0;
 		{
-			REQUIRE(stack(1).index() == 1);	// Always false
-			REQUIRE(stack(2).index() == 1);	// Always false
+			MemoContext const outer{};
+			REQUIRE(!shared(1));
+			{
+				MemoContext const inner{};
+				REQUIRE(shared(5));
+			}
+			REQUIRE(!shared(1));	// the inner evaluation took the slot
 		}
-		else
+		REQUIRE(calls == 3);
+
+	}
+
+	{
+
+		// Same results as without memoization
+
+		auto plain = !expensive && makeValue || (expensive & isEven) && makeValueAlt || expensive + makeNothing && makeAddable || makeNonDefault;
+		auto ticked = WithMemo(tree);
+
+		for (int i{}; i < 6; ++i)
 		{
-			REQUIRE(std::get<1>(stack(1)).index() == 0);
-			REQUIRE(std::get<1>(stack(2)).index() == 1);
+			auto const a = plain(i);
+			auto const b = ticked(i);
+			REQUIRE(a.index() == b.index());
 		}
 
 	}
 
 }
 
-TEST_CASE("Test dynamic action")
+TEST_CASE("Test adaptive decision")
 {
 
-	Action half{ [](int i) { return float(i) / 2.f; } };
-	Action sqr { [](int i) { return float(i) * float(i); } };
+	int slowCalls{}, fastCalls{};
 
+	// Slow and nearly always true, written first
+	Decision slow{ [&slowCalls](int i)
+	{
+		++slowCalls;
+		volatile std::uint64_t x{ std::uint64_t(i) };
+		for (int n{}; n < 2000; ++n)
+			x = x * 6364136223846793005ull + 1;
+		return i % 100 != 1;
+	} };
 
-	ActionDynamic<float(int)> act{ half };
-	REQUIRE_TYPE(float, act(0));
+	// Fast and rarely true
+	Decision fast{ [&fastCalls](int i) { ++fastCalls; return i % 10 == 0; } };
 
-	REQUIRE(act(3) == 1.5f);
-	
-	act = sqr;
-	REQUIRE(act(3) == 9.0f);
+	{
+
+		// The cheap and selective operand moves to the front, results stay the same
+
+		auto all = Adaptive(slow & isNotZero & fast);
+		auto any = Adaptive(!slow | !isNotZero | !fast);
+
+		int wrong{};
+		for (int i{}; i < 4096; ++i)
+		{
+			bool const expected{ i != 0 && i % 10 == 0 && i % 100 != 1 };
+			wrong += all(i) != expected;
+			wrong += any(i) != !expected;
+		}
+		REQUIRE(wrong == 0);
+		REQUIRE(all.Order()[0] != 0);
+		REQUIRE(any.Order()[0] != 0);
+
+		slowCalls = fastCalls = 0;
+		for (int i{}; i < 1000; ++i)
+			(void)all(i);
+		REQUIRE(slowCalls < 250);
+
+	}
+
+	{
+
+		// Off: the order as written, left to right
+
+		auto all = Adaptive(slow & fast);
+		for (int i{}; i < 4096; ++i)
+			(void)all(i);
+
+		all.Enable(false);
+		REQUIRE(all.Order()[0] == 0);
+
+		slowCalls = fastCalls = 0;
+		for (int i{}; i < 1000; ++i)
+			(void)all(i);
+		REQUIRE(slowCalls == 1000);
+		REQUIRE(fastCalls == 990);
+
+		// Never sampled: it never reorders either
+
+		auto never = Adaptive(slow & fast, AdaptiveOptions{ .sample = 0 });
+		slowCalls = fastCalls = 0;
+		for (int i{}; i < 4096; ++i)
+			(void)never(i);
+		REQUIRE(never.Order()[0] == 0);
+		REQUIRE(slowCalls == 4096);
+
+	}
+
+	{
+
+		// Nested groups of the same kind are flattened, other groups adapt on their own
+
+		auto nested = Adaptive((slow & fast) & (isEven | fast), AdaptiveOptions{ 64, 4 });
+		REQUIRE(nested.Order().size() == 3);
+		REQUIRE(std::get<2>(nested.operands).Order().size() == 2);
+		REQUIRE(std::get<2>(nested.operands).options.period == 64);
+		REQUIRE(nested(10) == true);
+		REQUIRE(nested(5)  == false);
+
+	}
+
+}
+
+#ifdef __cpp_lib_span
+
+TEST_CASE("Test batch evaluation")
+{
+
+	std::vector<int> input(100);
+	for (int i{}; i < 100; ++i)
+		input[i] = i - 20;
+
+	std::span<int const> in{ input };
+
+	{
+
+		// Same results as calling the tree for every input
+
+		auto select = [](int i) { return Decision{ [i](int j) { return i == j; } }; };
+
+		auto conditional = isEven & makeValue;
+		auto stack       = select(0) && makeValue || (isEven & !isGreaterEqualTwo) && makeNothing || isNotZero && makeAddable || makeNonDefault;
+		auto keyed       = Switch{ Action{ [](int i) { return i % 4; } }, on<0>(makeValue), on<1, 2>(makeNothing) } || makeAddable;
+
+		std::vector<impl::Maybe<Value>> conditionalOut(in.size());
+		std::vector<decltype(stack(0))> stackOut      (in.size());
+		std::vector<decltype(keyed(0))> keyedOut      (in.size());
+
+		EvaluateBatch(conditional, in, std::span{ conditionalOut });
+		EvaluateBatch(stack      , in, std::span{ stackOut       });
+		EvaluateBatch(keyed      , in, std::span{ keyedOut       });
+
+		bool test{ true };
+		for (size_t i{}; i < in.size(); ++i)
+		{
+			auto const a = conditional(in[i]);
+			auto const b = stack      (in[i]);
+			auto const c = keyed      (in[i]);
+			test &= a.has_value() == conditionalOut[i].has_value() && (!a || a->value == conditionalOut[i]->value);
+			test &= b.index() == stackOut[i].index();
+			test &= c.index() == keyedOut[i].index();
+		}
+		REQUIRE(test);
+
+	}
+
+	{
+
+		// Short circuit is kept, actions only run for the inputs that reach them
+
+		int left{}, right{}, actions{};
+
+		Decision countLeft { [&left ](int i) { ++left;  return i >= 0; } };
+		Decision countRight{ [&right](int i) { ++right; return i % 10 == 0; } };
+		Action   countRun  { [&actions](int) { ++actions; } };
+
+		auto tree = countLeft & countRight & countRun;
+
+		EvaluateBatch(tree, in);
+		REQUIRE(left    == 100);
+		REQUIRE(right   ==  80);
+		REQUIRE(actions ==   8);
+
+	}
+
+	{
+
+		// Batch overloads of decisions
+
+		int scalar{}, batch{};
+
+		Decision positive{ JL::Visitor{
+			[&scalar](int i) { ++scalar; return i > 0; },
+			[&batch ](std::span<int const> in, std::span<std::uint8_t> mask)
+			{
+				++batch;
+				for (size_t i{}; i < in.size(); ++i)
+					mask[i] = in[i] > 0;
+			}
+		} };
+
+		bool out[100]{};
+		EvaluateBatch(positive, in, std::span<bool>{ out });
+
+		REQUIRE(batch  == 1);
+		REQUIRE(scalar == 0);
+		REQUIRE(out[20] == false);
+		REQUIRE(out[21] == true );
+
+	}
+
+}
+
+#endif
+
+TEST_CASE("Test parallel sequence")
+{
+
+	ThreadPool pool{ 2 };
+
+	{
+
+		// Same results as a sequence
+
+		auto parallel = Parallel(pool, makeValue, makeNothing, makeAddable, makeAddableAlt);
+		auto sequence = makeValue | makeNothing | makeAddable | makeAddableAlt;
+		auto summed   = Parallel(pool, makeAddable, makeAddableAlt, makeValue);
+
+		using Flat   = std::tuple<Value, Addable, Addable>;
+		using Summed = std::tuple<Addable, Value>;
+		REQUIRE_TYPE(Flat  , parallel(0));
+		REQUIRE_TYPE(Summed, summed  (0));
+
+		auto [p1, p2, p3] = parallel(7);
+		auto [s1, s2, s3] = sequence(7);
+		REQUIRE(p1.value == s1.value);
+		REQUIRE(p2.value == s2.value);
+		REQUIRE(p3.value == s3.value);
+
+		REQUIRE(std::get<0>(summed(7)).value == (7 * 2) + (7 * 5));
+
+	}
+
+	{
+
+		// Runs on the pool, nested sequences do not dead lock
+
+		std::atomic<int> pooled{};
+		auto const caller = std::this_thread::get_id();
+
+		// Sleeps, so that the workers get a core to steal on even when there is only one
+		Action where{ [&](int)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds{ 50 });
+			pooled += std::this_thread::get_id() != caller;
+			return 1;
+		} };
+		auto inner = Parallel(pool, where, where, where);
+		auto outer = Parallel(pool, inner, inner, inner, inner);
+
+		for (int i{}; i < 20; ++i)
+			REQUIRE(outer(0) == 12);
+		REQUIRE(pooled > 0);
+
+	}
+
+	{
 
-}
\ No newline at end of file
+		// Errors are passed on after every action has finished
+
+		std::atomic<int> finished{};
+
+		Action fine { [&](int) { ++finished; } };
+		Action fails{ [&](int) { ++finished; throw std::runtime_error{ "fails" }; } };
+
+		auto parallel = Parallel(pool, fails, fine, fails, fine);
+		REQUIRE_THROWS_AS(parallel(0), std::runtime_error);
+		REQUIRE(finished == 4);
+
+	}
+
+}
+
+#ifdef __cpp_impl_coroutine
+
+#include <coroutine>
+#include <deque>
+
+// Fake I/O, a read waits until the test pushes a value
+struct FakeSource
+{
+	EventLoop&                          loop;
+	std::deque<int>                     data{};
+	std::deque<std::coroutine_handle<>> readers{};
+
+	struct Read
+	{
+		FakeSource& source;
+
+		bool await_ready() const { return !source.data.empty(); }
+		void await_suspend(std::coroutine_handle<> h) { source.readers.push_back(h); }
+		int  await_resume() { int const v{ source.data.front() }; source.data.pop_front(); return v; }
+	};
+
+	Read read() { return { *this }; }
+
+	void push(int v)
+	{
+		data.push_back(v);
+		if (!readers.empty())
+		{
+			loop.Post(readers.front());
+			readers.pop_front();
+		}
+	}
+};
+
+TEST_CASE("Test async")
+{
+
+	EventLoop  loop{};
+	FakeSource source{ loop };
+
+	Action   read   { [&](int)   { return source.read(); } };
+	Action   fetch  { [&](int i) -> Task<Addable> { co_return Addable{ co_await source.read() + i }; } };
+	Decision arrived{ [&](int)   -> Task<bool>    { co_return co_await source.read() != 0; } };
+
+	auto run = [&](auto task, int value)
+	{
+		task.Start();
+		source.push(value);
+		loop.Run();
+		REQUIRE(task.Done());
+		return task.Get();
+	};
+
+	{
+
+		// Only trees with an awaitable in them become a task
+
+		REQUIRE_TYPE(Value, (makeNothing | makeValue)(0));
+		REQUIRE_TYPE(Task<int>, (makeNothing | read)(0));
+
+		auto tree = makeValue | fetch | makeNothing | makeAddable;
+
+		using Flat = std::tuple<Value, Addable, Addable>;
+		REQUIRE_TYPE(Task<Flat>, tree(3));
+
+		auto task = tree(3);
+		task.Start();
+		REQUIRE(!task.Done());
+		source.push(10);
+		REQUIRE(!task.Done());
+		loop.Run();
+
+		auto [a, b, c] = task.Get();
+		REQUIRE(a.value == 3);
+		REQUIRE(b.value == 13);
+		REQUIRE(c.value == 6);
+
+		auto visited = read | JL::Visitor{ [](int i) { return i * 2; } };
+		REQUIRE(run(visited(0), 21) == 42);
+
+	}
+
+	{
+
+		// Decisions short circuit, edges keep their state
+
+		int fired{};
+		Action fire{ [&](int) { ++fired; } };
+
+		auto slow  = (arrived | isNotZero) & makeValue;
+		auto quick = (isNotZero | arrived) & makeValue;
+
+		REQUIRE_TYPE(Task<std::optional<Value>>, slow(0));
+		REQUIRE(run(slow(4), 0)->value == 4);
+		REQUIRE(!run(slow(0), 0));
+
+		auto task = quick(2);
+		task.Start();
+		REQUIRE(task.Done());
+		REQUIRE(task.Get()->value == 2);
+
+		auto rising = arrived + fire;
+		for (int v : { 0, 1, 1, 0, 1 })
+			(void)run(rising(0), v);
+		REQUIRE(fired == 2);
+
+	}
+
+	{
+
+		// Stacks and switches
+
+		auto stack = isEven && fetch || arrived && makeValue || makeNothing;
+
+		using Flat = std::variant<Addable, Value, std::monostate>;
+		REQUIRE_TYPE(Task<Flat>, stack(0));
+
+		REQUIRE(std::get<Addable>(run(stack(2), 5)).value == 7);
+		REQUIRE(std::get<Value>(run(stack(3), 1)).value == 3);
+		REQUIRE(run(stack(3), 0).index() == 2);
+
+		auto keyed = Switch{ read, on<1>(makeValue), on<2>(makeAddable) } || makeValueAlt;
+
+		REQUIRE(std::get<Value>(run(keyed(4), 1)).value == 4);
+		REQUIRE(std::get<Addable>(run(keyed(4), 2)).value == 8);
+		REQUIRE(std::get<Value>(run(keyed(4), 9)).value == 12);
+
+	}
+
+	{
+
+		// One loop drives many trees, frames are reused once they are done
+
+		int done{};
+		auto tree = fetch | JL::Visitor{ [&](Addable a) { done += a.value; } };
+
+		auto wave = [&]
+		{
+			for (int i{}; i < 200; ++i)
+				loop.Spawn(tree(1));
+			loop.Run();
+			REQUIRE(loop.Pending() == 200);
+			for (int i{}; i < 200; ++i)
+				source.push(1);
+			loop.Run();
+			REQUIRE(loop.Pending() == 0);
+		};
+
+		wave();
+		REQUIRE(done == 400);
+
+		size_t const fresh{ impl::FramePool::Local().Fresh() };
+		wave();
+		REQUIRE(done == 800);
+		REQUIRE(impl::FramePool::Local().Fresh() == fresh);
+
+	}
+
+	{
+
+		// Cancelled tasks end at their next suspension point
+
+		int ran{};
+		Action after{ [&](int) { ++ran; } };
+
+		auto tree = fetch | after;
+
+		auto task = tree(0);
+		task.Start();
+		task.Cancel();
+		source.push(1);
+		loop.Run();
+
+		REQUIRE(task.Done());
+		REQUIRE_THROWS_AS(task.Get(), Cancelled);
+		REQUIRE(ran == 0);
+
+		Action failing{ [&](int) -> Task<> { co_await source.read(); throw std::runtime_error{ "fails" }; } };
+		loop.Spawn(failing(0));
+		source.push(1);
+		REQUIRE_THROWS_AS(loop.Run(), std::runtime_error);
+
+	}
+
+	{
+
+		// Started once: a task that waits is resumed by what it waits on, not by another Start or a spawn
+
+		FakeSource fresh{ loop };
+
+		int reads{};
+		Action count{ [&](int) -> Task<int> { int const v{ co_await fresh.read() }; ++reads; co_return v; } };
+
+		auto task = count(0);
+		task.Start();
+		task.Start();
+		fresh.push(7);
+		task.Start();
+		loop.Run();
+
+		REQUIRE(task.Done());
+		REQUIRE(task.Get() == 7);
+		REQUIRE(reads == 1);
+
+		auto spawned = count(0);
+		spawned.Start();
+		loop.Spawn(std::move(spawned));
+		fresh.push(8);
+		loop.Run();
+
+		REQUIRE(reads == 2);
+		REQUIRE(loop.Pending() == 0);
+
+	}
+
+	{
+
+		// Tasks still pending when their loop goes away are destroyed with it
+
+		struct Guard
+		{
+			int& count;
+			~Guard() { ++count; }
+		};
+
+		int destroyed{};
+		{
+			EventLoop  local{};
+			FakeSource never{ local };
+
+			Action wait{ [&](int) -> Task<> { Guard const guard{ destroyed }; co_await never.read(); } };
+			local.Spawn(wait(0));
+			local.Spawn(wait(0));
+			local.Run();
+
+			REQUIRE(local.Pending() == 2);
+			REQUIRE(destroyed == 0);
+		}
+		REQUIRE(destroyed == 2);
+
+	}
+
+}
+
+#endif
+
+TEST_CASE("Test pipeline")
+{
+
+	{
+
+		// Each stage gets the result of the one before, results come out in order
+
+		Action parse { [](int i) { return Part<int>{ {}, i }; } };
+		Action square{ [](Part<int>&& p) { return Part<long>{ {}, long(p.value) * p.value }; } };
+		Action text  { [](Part<long>&& p) { return std::to_string(p.value); } };
+
+		Counted::reset();
+		auto pipeline = Pipeline<int>(4, parse, square, text);
+		REQUIRE_TYPE(std::optional<std::string>, pipeline.Pop());
+
+		int pushed{};
+		std::thread feed{ [&]
+		{
+			for (int i{}; i < 1000; ++i)
+				pushed += pipeline.Push(i);
+			pipeline.Close();
+		} };
+
+		int count{};
+		while (auto out = pipeline.Pop())
+		{
+			REQUIRE(*out == std::to_string(long(count) * count));
+			++count;
+		}
+		feed.join();
+		pipeline.Wait();
+
+		REQUIRE(pushed == 1000);
+		REQUIRE(count  == 1000);
+		REQUIRE(Counted::copies == 0);
+		REQUIRE(!pipeline.Push(0));
+
+		for (auto const& stage : pipeline.Stats())
+		{
+			REQUIRE(stage.items == 1000);
+			REQUIRE(stage.peak <= 4);
+			REQUIRE(stage.occupancy <= 1.);
+		}
+
+	}
+
+	{
+
+		// A slow stage holds back the ones before it
+
+		std::atomic<int> parsed{}, written{};
+
+		Action parse{ [&](int i) { ++parsed; return i; } };
+		Action write{ [&](int)   { std::this_thread::sleep_for(std::chrono::microseconds{ 200 }); ++written; } };
+
+		auto pipeline = Pipeline<int>(2, parse, write);
+		for (int i{}; i < 50; ++i)
+		{
+			REQUIRE(pipeline.Push(i));
+			REQUIRE(parsed - written <= 2 + 1);
+		}
+		pipeline.Wait();
+
+		REQUIRE(written == 50);
+		REQUIRE(pipeline.Stats()[1].peak <= 2);
+
+	}
+
+	{
+
+		// Errors stop the pipeline, items in flight are dropped on destruction
+
+		Action fails{ [](int i) { if (i == 10) throw std::runtime_error{ "fails" }; return i; } };
+		Action slow { [](int)   { std::this_thread::sleep_for(std::chrono::milliseconds{ 1 }); } };
+
+		auto pipeline = Pipeline<int>(fails, slow);
+		int pushed{};
+		while (pipeline.Push(pushed))
+			++pushed;
+		REQUIRE(pushed >= 10);
+		REQUIRE_THROWS_AS(pipeline.Wait(), std::runtime_error);
+
+		auto abandoned = Pipeline<int>(2, slow);
+		for (int i{}; i < 3; ++i)
+			abandoned.Push(i);
+
+	}
+
+}
+
+TEST_CASE("Test blackboard")
+{
+
+	struct Health : Entry<int> {};
+	struct Ammo   : Entry<int> {};
+	struct Line   { char bytes[56]; };
+
+	using Board = Blackboard<Health, Ammo, double, Line, std::string>;
+	Board board{};
+
+	{
+
+		// Entries by tag or by type, at offsets known at compile time
+
+		static_assert(Board::Offset<Health>() == 0);
+		static_assert(Board::Offset<Ammo>()   == sizeof(int));
+		static_assert(Board::Offset<double>() == 8);
+		static_assert(Board::Offset<Line>()   == 64);	// would straddle two cache lines
+		static_assert(alignof(Board) == 64);
+		static_assert(alignof(Blackboard<Health, Ammo, double>) == 16);
+		static_assert(sizeof (Blackboard<Health, Ammo, double>) == 16);
+
+		REQUIRE(board.Get<Health>() == 0);
+		REQUIRE(board.Get<std::string>().empty());
+		board.Get<Health>() = 100;
+		board.Get<Ammo>()   = 3;
+		REQUIRE(board.Get<Health>() == 100);
+		REQUIRE(board.Get<Ammo>()   == 3);
+
+		REQUIRE((char*)&board.Get<Line>() - (char*)&board == 64);
+
+	}
+
+	{
+
+		// Nodes take the entries they use, then the arguments after the board
+
+		Decision isHurt { Uses<Health>([](int& health, int) { return health < 30; }) };
+		Decision hasAmmo{ Uses<Ammo>  ([](int ammo, int) { return ammo > 0; }) };
+		Action   shoot  { Uses<Ammo, std::string>([](int& ammo, std::string& log, int target) { --ammo; log += "shoot "; return target; }) };
+		Action   flee   { Uses<std::string>([](std::string& log, int) { log += "flee "; return -1; }) };
+		Action   damage { Uses<Health>([](int& health, int) { health -= 40; }) };
+
+		auto tree = isHurt && flee || hasAmmo && shoot || flee;
+
+		REQUIRE(tree(board, 7) == 7);
+		REQUIRE(tree(board, 8) == 8);
+		REQUIRE(tree(board, 9) == 9);
+		REQUIRE(board.Get<Ammo>() == 0);
+		REQUIRE(tree(board, 9) == -1);
+
+		damage(board, 0);
+		damage(board, 0);
+		board.Get<Ammo>() = 5;
+		REQUIRE(tree(board, 9) == -1);
+		REQUIRE(board.Get<Ammo>() == 5);
+		REQUIRE(board.Get<std::string>() == "shoot shoot shoot flee flee ");
+
+	}
+
+	{
+
+		// One board per instance, copies are independent
+
+		Board other{ board };
+		other.Get<std::string>() += "more";
+		REQUIRE(board.Get<std::string>() == "shoot shoot shoot flee flee ");
+		REQUIRE(other.Get<std::string>() == "shoot shoot shoot flee flee more");
+
+		board = std::move(other);
+		REQUIRE(board.Get<std::string>() == "shoot shoot shoot flee flee more");
+
+	}
+
+}
+
+TEST_CASE("Test resumable tree")
+{
+
+	// An action that takes `ticks` calls, counting how often it ran
+	auto takes = [](int ticks, int& calls)
+	{
+		return Action{ [ticks, &calls, left = ticks](int) mutable
+		{
+			++calls;
+			if (--left > 0)
+				return Status::Running;
+			left = ticks;
+			return Status::Success;
+		} };
+	};
+
+	int walked{}, opened{}, entered{}, asked{}, fled{};
+	Action   walk   = takes(3, walked);
+	Action   open   = takes(2, opened);
+	Action   enter  = takes(1, entered);
+	Action   fail   { [](int) { return Status::Failure; } };
+	Decision isDoor { [&asked](int i) { ++asked; return i > 0; } };
+	Action   flee   = takes(1, fled);
+
+	{
+
+		// Sequences continue at the action that was running
+
+		auto tree = Resumable(walk | open | enter);
+		REQUIRE(tree(0) == Status::Running);
+		REQUIRE(tree(0) == Status::Running);
+		REQUIRE(tree(0) == Status::Running);
+		REQUIRE(tree(0) == Status::Success);
+		REQUIRE(walked == 3);
+		REQUIRE(opened == 2);
+		REQUIRE(entered == 1);
+
+		// And start over once they are done
+		REQUIRE(tree(0) == Status::Running);
+		REQUIRE(walked == 4);
+
+		Halt(tree);
+		REQUIRE(tree(0) == Status::Running);
+		REQUIRE(walked == 5);
+
+		auto failing = Resumable(fail | enter);
+		REQUIRE(failing(0) == Status::Failure);
+		REQUIRE(entered == 1);
+
+	}
+
+	{
+
+		// Decisions above a running action are not asked again
+
+		walked = opened = entered = asked = 0;
+		auto tree = Resumable(isDoor && (open | enter) || flee);
+
+		REQUIRE(tree(1) == Status::Running);
+		REQUIRE(asked == 1);
+		REQUIRE(tree(-1) == Status::Success);
+		REQUIRE(asked == 1);
+		REQUIRE(entered == 1);
+		REQUIRE(fled == 0);
+
+		REQUIRE(tree(-1) == Status::Success);
+		REQUIRE(asked == 2);
+		REQUIRE(fled == 1);
+
+		auto conditional = Resumable(isDoor & open | enter);
+		REQUIRE(conditional(1) == Status::Running);
+		REQUIRE(conditional(-1) == Status::Success);
+		REQUIRE(asked == 3);
+		REQUIRE(conditional(-1) == Status::Failure);
+		REQUIRE(asked == 4);
+
+	}
+
+	{
+
+		// Nodes without a status run as they always do
+
+		Action twice{ [](int i) { return i * 2; } };
+		auto tree = Resumable(isDoor && twice | twice || twice);
+		REQUIRE(tree(3) == 12);
+		REQUIRE(tree(-3) == -6);
+
+	}
+
+}
+
+TEST_CASE("Test reactive tree")
+{
+
+	enum Input { Health, Ammo, Enemies };
+	int health{ 100 }, ammo{ 10 }, enemies{};
+	int asked{};
+
+	Decision isHurt  = Reads(Decision{ [&](int) { ++asked; return health < 30; } }, Health);
+	Decision hasAmmo = Reads(Decision{ [&](int) { ++asked; return ammo > 0; } }, Ammo);
+	Decision sees    = Reads(Decision{ [&](int) { ++asked; return enemies > 0; } }, Enemies);
+	Decision always  { [&](int) { ++asked; return true; } };
+
+	Action flee  { [](int) { return 1; } };
+	Action shoot { [](int) { return 2; } };
+	Action idle  { [](int) { return 3; } };
+
+	{
+
+		// Decisions run again only when an input they read was touched
+
+		auto tree = Reactive(isHurt && flee || sees & hasAmmo && shoot || idle);
+		REQUIRE(tree.Cells() == 4);
+
+		REQUIRE(tree(0) == 3);
+		REQUIRE(asked == 2);		// sees was false, hasAmmo did not run
+		REQUIRE(tree(0) == 3);
+		REQUIRE(asked == 2);
+
+		enemies = 1;
+		REQUIRE(tree(0) == 3);		// not touched yet
+		tree.Touch(Enemies);
+		REQUIRE(tree(0) == 2);
+		REQUIRE(asked == 4);		// sees and hasAmmo
+		REQUIRE(tree(0) == 2);
+		REQUIRE(asked == 4);
+
+		ammo = 0;
+		tree.Touch(Ammo);
+		REQUIRE(tree(0) == 3);
+		REQUIRE(asked == 5);
+
+		health = 10;
+		tree.Touch(Health);
+		REQUIRE(tree(0) == 1);
+		REQUIRE(asked == 6);
+
+		tree.TouchAll();
+		REQUIRE(tree(0) == 1);
+		REQUIRE(asked == 7);
+
+	}
+
+	{
+
+		// Decisions that do not say what they read run every call, so do the decisions above them
+
+		asked = 0;
+		health = 100;
+		auto tree = Reactive(!isHurt & always & idle);
+		REQUIRE(tree.Cells() == 1);
+		REQUIRE(tree(0) == 3);
+		REQUIRE(tree(0) == 3);
+		REQUIRE(asked == 3);
+
+	}
+
+	{
+
+		// Edges fire on the kept results
+
+		int alarms{};
+		Action alarm{ [&alarms](int) { ++alarms; } };
+		auto tree = Reactive(sees +alarm);
+
+		enemies = 0;
+		tree(0);
+		enemies = 1;
+		tree(0);
+		REQUIRE(alarms == 0);
+		tree.Touch(Enemies);
+		tree(0);
+		tree(0);
+		REQUIRE(alarms == 1);
+
+	}
+
+}
+
+TEST_CASE("Test script")
+{
+
+	Registry<int(int)> registry{};
+
+	std::string log{};
+	registry.Add("isHigh",  Decision{ [](int i) { return i > 5; } });
+	registry.Add("isEven",  Decision{ [](int i) { return i % 2 == 0; } });
+	registry.Add("double",  Action{ [](int i) { return i * 2; } });
+	registry.Add("negate",  Action{ [](int i) { return -i; } });
+	registry.Add("open",    Action{ [&log](int) { log += "open "; } });
+	registry.Add("close",   Action{ [&log](int) { log += "close "; return 100; } });
+
+	{
+
+		// Same operators and precedence as a tree
+
+		auto sequence = registry.ParseAction("double | negate | double");
+		REQUIRE(sequence(3) == 9);
+
+		auto stack = registry.ParseAction("isHigh && double || isEven && negate || double | double");
+		REQUIRE(stack(7) == 14);
+		REQUIRE(stack(2) == -2);
+		REQUIRE(stack(3) == 12);
+
+		auto conditional = registry.ParseAction("isHigh & !isEven & double");
+		REQUIRE(conditional(7) == 14);
+		REQUIRE(!conditional(8));
+		REQUIRE(!conditional(1));
+
+		auto decision = registry.ParseDecision("(isHigh | isEven) && !(isHigh && isEven)");
+		REQUIRE(decision(7));
+		REQUIRE(decision(2));
+		REQUIRE(!decision(8));
+		REQUIRE(!decision(1));
+
+	}
+
+	{
+
+		// Edges keep their state per script, their actions do not add to the result
+
+		auto edges = registry.ParseAction("isHigh +open -close & double");
+		REQUIRE(edges(1) == std::nullopt);
+		REQUIRE(log == "close ");
+		REQUIRE(edges(7) == 14);
+		REQUIRE(edges(9) == 18);
+		REQUIRE(edges(1) == std::nullopt);
+		REQUIRE(log == "close open close ");
+
+		// The same as the tree
+		Decision isHigh{ [](int i) { return i > 5; } };
+		Action   open  { [&log](int) { log += "open "; } };
+		Action   close { [&log](int) { log += "close "; return 100; } };
+		Action   twice { [](int i) { return i * 2; } };
+		auto tree = isHigh +open -close & twice;
+
+		auto fresh = registry.ParseAction("isHigh +open -close & double");
+		std::vector<std::optional<int>> results{};
+
+		log.clear();
+		for (int i : { 1, 7, 9, 1, 8, 2 })
+			results.push_back(fresh(i));
+		std::string const scripted = log;
+
+		log.clear();
+		size_t n{};
+		for (int i : { 1, 7, 9, 1, 8, 2 })
+			REQUIRE(tree(i) == results[n++]);
+		REQUIRE(scripted == log);
+
+	}
+
+	{
+
+		// Errors point at the source
+
+		auto fails = [&registry](std::string_view source, size_t position)
+		{
+			try
+			{
+				(void)registry.ParseAction(source);
+			}
+			catch (ScriptError const& error)
+			{
+				return error.Position() == position;
+			}
+			return false;
+		};
+
+		REQUIRE(fails("double | nothing", 9));
+		REQUIRE(fails("double | isHigh", 9));
+		REQUIRE(fails("isHigh && double", 0));
+		REQUIRE(fails("double && isHigh", 0));
+		REQUIRE(fails("(double", 7));
+		REQUIRE(fails("double )", 7));
+		REQUIRE(fails("isHigh", 0));
+		REQUIRE_THROWS_AS(registry.ParseDecision("double"), ScriptError);
+
+	}
+
+	{
+
+		// A script is an action like any other
+
+		Action scripted{ registry.ParseAction("isEven & negate") };
+		Action twice   { [](int i) { return i * 2; } };
+		auto tree = scripted | twice;
+		REQUIRE(tree(4) == std::tuple{ std::optional{ -4 }, 8 });
+
+	}
+
+}
+
+TEST_CASE("Test constexpr tree")
+{
+
+	constexpr Decision isHigh{ [](int i) { return i > 5; } };
+	constexpr Decision isEven{ [](int i) { return i % 2 == 0; } };
+	constexpr Action   twice { [](int i) { return i * 2; } };
+	constexpr Action   negate{ [](int i) { return -i; } };
+
+	constexpr auto stack = isHigh && twice || isEven && negate || twice | twice;
+
+	{
+
+		// Trees of constexpr lambdas run while compiling
+
+		static_assert(Fold(stack, 7) == 14);
+		static_assert(Fold(stack, 2) == -2);
+		static_assert(Fold(stack, 3) == 12);
+
+		constexpr auto conditional = isHigh & !isEven & twice;
+		static_assert(Fold(conditional, 7) == 14);
+		static_assert(!Fold(conditional, 8));
+
+		static_assert( Fold((isHigh | isEven) && !(isHigh && isEven), 7));
+		static_assert(!Fold((isHigh | isEven) && !(isHigh && isEven), 8));
+
+		// Edges keep their state for the length of the fold
+		static_assert(Fold(isHigh +twice -negate & twice, 9) == 18);
+
+	}
+
+	{
+
+		// Lookup tables with the result for every key
+
+		static constexpr auto table = Tabulate<16, int>(stack);
+		static_assert(table[7] == 14);
+
+		auto tree = stack;
+		for (int key{}; key < 16; ++key)
+			REQUIRE(table[key] == tree(key));
+
+		static constexpr auto holds = Tabulate<16, int>(isHigh | isEven);
+		static_assert(std::is_same_v<decltype(holds), std::array<bool, 16> const>);
+		REQUIRE(std::count(holds.begin(), holds.end(), true) == 13);
+
+	}
+
+}
+
+TEST_CASE("Test hot swap")
+{
+
+	{
+
+		// Calls run the subtree that is live
+
+		HotSwap<int(int)> swap{ Action{ [](int i) { return i + 1; } } };
+		auto tree = Decision{ [](int i) { return i > 0; } } && Live(swap) || Action{ [](int) { return 0; } };
+		REQUIRE(tree(1) == 2);
+
+		swap.Swap(Decision{ [](int i) { return i > 2; } } && Action{ [](int i) { return i * 10; } } || Action{ [](int i) { return -i; } });
+		REQUIRE(tree(3) == 30);
+		REQUIRE(tree(2) == -2);
+		REQUIRE(tree(-1) == 0);
+
+		HotSwap<bool(int)> check{ Decision{ [](int i) { return i > 5; } } };
+		auto gated = Live(check) & Action{ [](int i) { return i; } };
+		REQUIRE(!gated(3));
+		check.Swap(Decision{ [](int i) { return i > 2; } });
+		REQUIRE(gated(3) == 3);
+
+	}
+
+	{
+
+		// Readers on 4 threads while the subtree is swapped 2000 times. A subtree that has been freed marks itself,
+		// readers see the versions in the order they were made live.
+
+		struct Version
+		{
+			int               id;
+			std::atomic<int>* freed;
+			bool              alive{ true };
+
+			Version(int id, std::atomic<int>* freed) : id{ id }, freed{ freed } {}
+			Version(Version&& other) noexcept : id{ other.id }, freed{ other.freed } { other.alive = false; }
+			~Version() { if (alive) ++*freed; alive = false; }
+
+			int operator () (int) const { return alive ? id : -1; }
+		};
+
+		constexpr int swaps = 2000;
+		std::atomic<int>  freed{};
+		std::atomic<bool> done{};
+		std::atomic<int>  stale{}, disordered{}, calls{};
+
+		HotSwap<int(int)> swap{ Action{ Version{ 0, &freed } } };
+		auto tree = Live(swap);
+
+		std::vector<std::thread> readers{};
+		for (int r{}; r < 4; ++r)
+			readers.emplace_back([&]
+			{
+				int last{};
+				auto reader = tree;
+				while (!done.load(std::memory_order_relaxed))
+				{
+					int const id = reader(0);
+					stale      += id < 0;
+					disordered += id < last;
+					last = id;
+					++calls;
+				}
+			});
+
+		while (calls < 4)
+			std::this_thread::yield();
+
+		// Swap only returns once the version it replaces is freed
+		int late{};
+		for (int i{ 1 }; i <= swaps; ++i)
+		{
+			swap.Swap(Action{ Version{ i, &freed } });
+			late += freed != i;
+		}
+		done = true;
+		for (auto& reader : readers)
+			reader.join();
+
+		REQUIRE(late == 0);
+		REQUIRE(stale == 0);
+		REQUIRE(disordered == 0);
+		REQUIRE(tree(0) == swaps);
+
+	}
+
+}
+
+TEST_CASE("Test stateless tree")
+{
+
+	Decision isHigh{ [](int i) { return i > 5; } };
+	Decision isEven{ [](int i) { return i % 2 == 0; } };
+	Action   twice { [](int i) { return i * 2; } };
+	Action   negate{ [](int i) { return -i; } };
+	Action   key   { [](int i) { return i % 4; } };
+
+	{
+
+		// Trees of nodes and leaves that keep nothing between calls can be called through a const reference
+
+		auto const stack    = isHigh && twice || isEven & !isHigh && negate || twice | negate;
+		auto const visited  = twice | negate | JL::Visitor{ [](int i) { return i + 1; } };
+		auto const switched = Switch{ key, on<0>(twice), on<1, 2>(negate) } || twice;
+		auto const gated    = (isHigh | isEven) & twice;
+
+		static_assert(is_stateless_v<decltype(stack), int>);
+		static_assert(is_stateless_v<decltype(visited), int>);
+		static_assert(is_stateless_v<decltype(switched), int>);
+		static_assert(is_stateless_v<decltype(gated), int>);
+
+		REQUIRE(stack(7) == 14);
+		REQUIRE(stack(2) == -2);
+		REQUIRE(stack(3) == 3);
+		REQUIRE(visited(3) == 4);
+		REQUIRE(switched(5) == -5);
+		REQUIRE(gated(2) == 4);
+		REQUIRE(!gated(3));
+
+	}
+
+	{
+
+		// Nodes and leaves that remember make the tree stateful
+
+		int calls{};
+		Action counted{ [calls](int i) mutable { return i + ++calls; } };
+		auto edge = isHigh +twice & negate;
+
+		static_assert(!is_stateless_v<decltype(counted), int>);
+		static_assert(!is_stateless_v<decltype(isHigh && counted || twice), int>);
+		static_assert(!is_stateless_v<decltype(edge), int>);
+		static_assert(!is_stateless_v<decltype(isEven && edge || twice), int>);
+		static_assert(!is_stateless_v<decltype(Resumable(twice | twice)), int>);
+		REQUIRE(edge(7) == -7);
+
+		// So do nodes that hide what is behind them
+
+		auto walled  = Firewall<std::optional<int>(int)>(edge);
+		auto dynamic = Action{ ActionDynamic<int(int)>{ twice } };
+		auto inplace = Action{ ActionDynamicInplace<int(int)>{ twice } };
+		HotSwap<int(int)> swap{ twice };
+
+		static_assert(!is_stateless_v<decltype(walled), int>);
+		static_assert(!is_stateless_v<decltype(isHigh && walled || twice), int>);
+		static_assert(!is_stateless_v<decltype(dynamic), int>);
+		static_assert(!is_stateless_v<decltype(inplace), int>);
+		static_assert(!is_stateless_v<decltype(Action{ ActionDynamicMoveOnly<int(int)>{ twice } }), int>);
+		static_assert(!is_stateless_v<decltype(Live(swap)), int>);
+
+		// Unless the subtree is known to keep no state
+
+		auto const subtree = isHigh && twice || negate;
+		auto const pure    = StatelessFirewall<int(int)>(subtree);
+		static_assert(is_stateless_v<decltype(pure), int>);
+		static_assert(is_stateless_v<decltype(isEven && pure || twice), int>);
+		REQUIRE(pure(7) == 14);
+		REQUIRE(pure(3) == -3);
+
+	}
+
+	{
+
+		// One instance for all threads
+
+		auto const tree = isHigh && twice || isEven && negate || twice | twice;
+
+		std::vector<int> expected(4096);
+		for (size_t i{}; i < expected.size(); ++i)
+			expected[i] = i > 5 ? int(i) * 2 : i % 2 == 0 ? -int(i) : int(i) * 4;
+
+		std::atomic<int> wrong{};
+		std::vector<std::thread> threads{};
+		for (int t{}; t < 4; ++t)
+			threads.emplace_back([&]
+			{
+				for (size_t i{}; i < expected.size(); ++i)
+					wrong += tree(int(i)) != expected[i];
+			});
+		for (auto& thread : threads)
+			thread.join();
+
+		REQUIRE(wrong == 0);
+
+	}
+
+}
+
+TEST_CASE("Test hints")
+{
+
+	Decision isHigh{ [](int i) { return i > 5; } };
+	Decision isZero{ [](int i) { return i == 0; } };
+	Action   twice { [](int i) { return i * 2; } };
+	Action   negate{ [](int i) { return -i; } };
+
+	{
+
+		// Hints change how the branches are laid out, never what the tree does
+
+		auto plain  = isZero && negate || isHigh && twice || negate | twice;
+		auto hinted = Unlikely(isZero) && negate || Likely(isHigh) && twice || negate | twice;
+		auto gate   = Unlikely(isZero) & twice;
+
+		int sum{};
+		auto count  = Likely(isHigh) & Action{ [&sum](int i) { sum += i; } };
+
+		for (int i{ -3 }; i < 12; ++i)
+		{
+			REQUIRE(hinted(i) == plain(i));
+			REQUIRE(gate(i) == (isZero & twice)(i));
+			count(i);
+		}
+		REQUIRE(sum == 6 + 7 + 8 + 9 + 10 + 11);
+
+	}
+
+	{
+
+		// Hint<0> leaves the decision as it is, a hint keeps a tree stateless
+
+		static_assert(std::is_same_v<decltype(Hint<0>(isHigh)), decltype(isHigh)>);
+		static_assert(std::is_same_v<decltype(Hint<1>(isHigh)), decltype(Likely(isHigh))>);
+		static_assert(is_stateless_v<decltype(Likely(isHigh) && twice || negate), int>);
+
+		auto const tree = Hint<-1>(isZero) && negate || twice;
+		REQUIRE(tree(0) == 0);
+		REQUIRE(tree(3) == 6);
+
+		constexpr auto folded = Unlikely(Decision{ [](int i) { return i == 0; } }) && Action{ [](int) { return 1; } } || Action{ [](int i) { return i * 3; } };
+		static_assert(Fold(folded, 0) == 1);
+		static_assert(Fold(folded, 2) == 6);
+
+	}
+
+	{
+
+		// Edges below a hint keep their state per instance
+
+		int opened{};
+		auto shared = Share(Likely(isHigh +Action{ [&opened](int) { ++opened; } }) && twice || negate);
+		auto states = shared.States(2);
+		static_assert(decltype(shared)::slots == 1);
+
+		REQUIRE(shared(states, 0, 7) == 14);
+		REQUIRE(shared(states, 0, 8) == 16);
+		REQUIRE(opened == 1);
+		REQUIRE(shared(states, 1, 7) == 14);
+		REQUIRE(opened == 2);
+
+	}
+
+#ifdef JL_ACTION_TREE_PROFILE
+
+	{
+
+		// Hints measured in one run, for the next build
+
+		ProfileReset();
+		auto tree = Label(isZero, "is zero") && negate || Label(isHigh, "isHigh") && twice || Label(Decision{ [](int i) { return i % 2 == 0; } }, "mixed") && negate || twice;
+		for (int i{ 1 }; i <= 100; ++i)
+			(void)tree(i);
+
+		std::ostringstream hints{};
+		ProfileHints(hints, "tuned");
+		std::string const text{ hints.str() };
+		REQUIRE(text.find("namespace tuned")               != std::string::npos);
+		REQUIRE(text.find("constexpr int is_zero = -1;")   != std::string::npos);
+		REQUIRE(text.find("constexpr int isHigh = 1;")     != std::string::npos);
+		REQUIRE(text.find("constexpr int mixed = 0;")      != std::string::npos);
+		ProfileReset();
+
+	}
+
+#endif
+
+}
+
+TEST_CASE("Test truth table")
+{
+
+	Decision isHigh { [](int i) { return i > 5; } };
+	Decision isEven { [](int i) { return i % 2 == 0; } };
+	Decision isThird{ [](int i) { return i % 3 == 0; } };
+	Action   twice  { [](int i) { return i * 2; } };
+	Action   negate { [](int i) { return -i; } };
+	Action   square { [](int i) { return i * i; } };
+
+	{
+
+		// The first branch whose decision holds, as in the stack
+
+		auto stack = isHigh & !isEven && twice || isEven && negate || isThird && square || twice | negate;
+		auto table = TruthTable(stack);
+
+		for (int i{ -20 }; i < 20; ++i)
+			REQUIRE(table(i) == stack(i));
+
+		// Results are combined in the same way
+		int ran{};
+		auto mixed       = isHigh && Action{ [&ran](int) { ++ran; } } || isEven && twice || negate;
+		auto mixedTable  = TruthTable(mixed);
+		static_assert(std::is_same_v<decltype(mixedTable(1)), decltype(mixed(1))>);
+		REQUIRE(!mixedTable(8));
+		REQUIRE(ran == 1);
+		REQUIRE(mixedTable(4) == 8);
+		REQUIRE(mixedTable(3) == -3);
+
+	}
+
+	{
+
+		// Every decision runs once, whichever branch is taken
+
+		int asked{};
+		Decision counted{ [&asked](int i) { ++asked; return i > 0; } };
+		auto table = TruthTable(counted && twice || counted && negate || counted && square || twice);
+		REQUIRE(table(3) == 6);
+		REQUIRE(asked == 3);
+		REQUIRE(table(-3) == -6);
+		REQUIRE(asked == 6);
+
+	}
+
+	{
+
+		// More branches than the table has bits, the first branch is found with a bit scan
+
+		auto wide = TruthTable(
+			Decision{ [](int i) { return i == 1; } } && twice ||
+			Decision{ [](int i) { return i == 2; } } && twice ||
+			Decision{ [](int i) { return i == 3; } } && twice ||
+			Decision{ [](int i) { return i == 4; } } && twice ||
+			Decision{ [](int i) { return i == 5; } } && twice ||
+			Decision{ [](int i) { return i == 6; } } && twice ||
+			Decision{ [](int i) { return i == 7; } } && twice ||
+			Decision{ [](int i) { return i == 8; } } && twice ||
+			isHigh && negate ||
+			isEven && square ||
+			square | negate
+		);
+		REQUIRE(wide(3) == 6);
+		REQUIRE(wide(8) == 16);
+		REQUIRE(wide(9) == -9);
+		REQUIRE(wide(-2) == 4);
+		REQUIRE(wide(-3) == 12);
+
+	}
+
+	{
+
+		// Stateless, constexpr and shared like the stack it was made from
+
+		auto const table = TruthTable(isHigh && twice || isEven && negate || square);
+		static_assert(is_stateless_v<decltype(table), int>);
+		REQUIRE(table(7) == 14);
+		REQUIRE(table(4) == -4);
+		REQUIRE(table(3) == 9);
+
+		constexpr auto folded = TruthTable(Decision{ [](int i) { return i > 5; } } && Action{ [](int) { return 1; } } || Action{ [](int) { return 2; } });
+		static_assert(Fold(folded, 9) == 1);
+		static_assert(Fold(folded, 2) == 2);
+
+		int opened{};
+		auto shared = Share(TruthTable(isHigh && (isEven +Action{ [&opened](int) { ++opened; } } & twice) || negate));
+		static_assert(decltype(shared)::slots == 1);
+		auto states = shared.States(2);
+		(void)shared(states, 0, 8);
+		(void)shared(states, 0, 10);
+		(void)shared(states, 1, 8);
+		REQUIRE(opened == 2);
+
+	}
+
+}
+
+TEST_CASE("Test expected sequence")
+{
+
+	using Error = std::string;
+
+	std::vector<std::string> ran{};
+	Action read     { [&ran](int i) -> Outcome<int, Error>         { ran.push_back("read");      if (i < 0)   return Failure<Error>{ "empty queue" }; return i; } };
+	Action serialize{ [&ran](int i) -> Outcome<std::string, Error> { ran.push_back("serialize"); if (i > 100) return Failure<Error>{ "too large" };   return std::to_string(i); } };
+	Action write    { [&ran](int)   -> Outcome<void, Error>        { ran.push_back("write");     return {}; } };
+	Action log      { [&ran](int)                                  { ran.push_back("log"); } };
+
+	auto chain = read | serialize | write;
+	using Chained = Outcome<std::tuple<int, std::string>, Error>;
+	REQUIRE_TYPE(Chained, chain(0));
+
+	{
+
+		// The first error ends the sequence, the stages after it do not run
+
+		auto done = chain(5);
+		REQUIRE(done.has_value());
+		REQUIRE(*done == std::tuple{ 5, std::string{ "5" } });
+		REQUIRE(ran == std::vector<std::string>{ "read", "serialize", "write" });
+
+		ran.clear();
+		auto empty = chain(-1);
+		REQUIRE(!empty.has_value());
+		REQUIRE(empty.error() == "empty queue");
+		REQUIRE(ran == std::vector<std::string>{ "read" });
+
+		ran.clear();
+		auto large = chain(200);
+		REQUIRE(large.error() == "too large");
+		REQUIRE(ran == std::vector<std::string>{ "read", "serialize" });
+
+	}
+
+	{
+
+		// Stages that can not fail add their results as always
+
+		auto logged = log | read | log;
+		REQUIRE_TYPE(decltype(read(0)), logged(0));
+
+		ran.clear();
+		REQUIRE(*logged(3) == 3);
+		REQUIRE(ran == std::vector<std::string>{ "log", "read", "log" });
+
+		ran.clear();
+		REQUIRE(logged(-3).error() == "empty queue");
+		REQUIRE(ran == std::vector<std::string>{ "log", "read" });
+
+		auto values = read | makeValue | serialize;
+		using Values = Outcome<std::tuple<int, Value, std::string>, Error>;
+		REQUIRE_TYPE(Values, values(0));
+		REQUIRE(std::get<1>(*values(4)).value == 4);
+
+		auto nothing = write | log | write;
+		REQUIRE_TYPE(decltype(write(0)), nothing(0));
+		REQUIRE(nothing(0).has_value());
+
+	}
+
+	{
+
+		// Visitors take the value or the error
+
+		auto report = chain | JL::Visitor{
+			[](std::tuple<int, std::string> const& done) { return std::get<1>(done); },
+			[](Error const& error) { return "error: " + error; },
+		};
+		REQUIRE(report(7) == "7");
+		REQUIRE(report(-7) == "error: empty queue");
+
+		auto status = write | JL::Visitor{ [] { return 0; }, [](Error const&) { return 1; } };
+		REQUIRE(status(0) == 0);
+
+		// unless a lambda takes the expected itself
+		auto whole = read | JL::Visitor{ [](Outcome<int, Error> const& outcome) { return outcome.has_value(); } };
+		REQUIRE(whole(1));
+		REQUIRE(!whole(-1));
+
+		auto const constant = read | serialize;
+		static_assert(is_stateless_v<decltype(constant), int>);
+		REQUIRE(constant(300).error() == "too large");
+
+	}
+
+#ifdef __cpp_impl_coroutine
+
+	{
+
+		// Sequences that wait stop at the first error as well
+
+		EventLoop  loop{};
+		FakeSource source{ loop };
+
+		Action fetch{ [&](int i) -> Task<Outcome<int, Error>>
+		{
+			int const v{ co_await source.read() };
+			ran.push_back("fetch");
+			if (v < 0)
+				co_return Failure<Error>{ "no data" };
+			co_return v + i;
+		} };
+
+		auto waiting = fetch | serialize | write;
+		REQUIRE_TYPE(Task<Chained>, waiting(0));
+
+		auto run = [&](int i, int v)
+		{
+			ran.clear();
+			auto task = waiting(i);
+			task.Start();
+			source.push(v);
+			loop.Run();
+			return task.Get();
+		};
+
+		REQUIRE(*run(1, 4) == std::tuple{ 5, std::string{ "1" } });
+		REQUIRE(ran == std::vector<std::string>{ "fetch", "serialize", "write" });
+
+		REQUIRE(run(1, -1).error() == "no data");
+		REQUIRE(ran == std::vector<std::string>{ "fetch" });
+
+		REQUIRE(run(150, 0).error() == "too large");
+		REQUIRE(ran == std::vector<std::string>{ "fetch", "serialize" });
+
+	}
+
+#endif
+
+	{
+
+		// Parallel actions give the same result, but all of them have run
+
+		ThreadPool pool{ 2 };
+		std::atomic<int> calls{};
+
+		Action positive{ [&calls](int i) -> Outcome<int, Error> { ++calls; if (i < 0) return Failure<Error>{ "negative" }; return i; } };
+		Action small   { [&calls](int i) -> Outcome<int, Error> { ++calls; if (i > 9) return Failure<Error>{ "large" };    return i * 2; } };
+
+		auto both = Parallel(pool, positive, small);
+		REQUIRE_TYPE(decltype((positive | small)(0)), both(0));
+
+		REQUIRE(*both(3) == 9);				// added, like in a sequence
+		REQUIRE(both(-1).error() == "negative");
+		REQUIRE(both(20).error() == "large");
+		REQUIRE(calls == 6);
+
+	}
+
+#ifdef __cpp_lib_expected
+
+	{
+
+		Action half{ [](int i) -> std::expected<int, Error> { if (i % 2) return std::unexpected<Error>{ "odd" }; return i / 2; } };
+		Action done{ [](int)   -> std::expected<void, Error> { return {}; } };
+
+		auto twice = half | half | done;
+		REQUIRE_TYPE(decltype(half(0)), twice(0));
+		REQUIRE(*twice(8) == 8);
+		REQUIRE(twice(3).error() == "odd");
+
+		auto visited = twice | JL::Visitor{ [](int i) { return i; }, [](Error const&) { return -1; } };
+		REQUIRE(visited(4) == 4);
+		REQUIRE(visited(5) == -1);
+
+	}
+
+#endif
+
+}
+
+TEST_CASE("Test shared tree")
+{
+
+	int opened{}, closed{};
+	Decision isHigh{ [](int i) { return i > 5; } };
+	Action   open  { [&opened](int) { ++opened; } };
+	Action   close { [&closed](int) { ++closed; } };
+	Action   work  { [](int i) { return i * 2; } };
+
+	auto tree = Share(isHigh +open -close & work);
+	static_assert(decltype(tree)::slots == 2);
+
+	auto states = tree.States(3);
+	REQUIRE(states.Size() == 3);
+
+	{
+
+		// Every instance has edges of its own
+
+		REQUIRE(tree(states, 0, 9) == 18);
+		REQUIRE(opened == 1);
+		REQUIRE(tree(states, 1, 9) == 18);
+		REQUIRE(opened == 2);
+		REQUIRE(tree(states, 0, 9) == 18);
+		REQUIRE(opened == 2);
+
+		// A falling edge starts on
+		REQUIRE(!tree(states, 2, 1));
+		REQUIRE(closed == 1);
+		REQUIRE(!tree(states, 2, 1));
+		REQUIRE(closed == 1);
+		REQUIRE(!tree(states, 0, 1));
+		REQUIRE(closed == 2);
+
+	}
+
+	{
+
+		// One column per edge, outer nodes first: -close, +open
+
+		REQUIRE(states.Column(0)[0] == false);
+		REQUIRE(states.Column(0)[1] == true);
+		REQUIRE(states.Column(0)[2] == false);
+		REQUIRE(states.Column(1)[1] == true);
+
+		states.Reset(1);
+		REQUIRE(states.Column(0)[1] == true);
+		REQUIRE(states.Column(1)[1] == false);
+		REQUIRE(tree(states, 1, 9) == 18);
+		REQUIRE(opened == 3);
+
+		states.Resize(5);
+		REQUIRE(states.Size() == 5);
+		REQUIRE(states.Column(0)[1] == true);
+		REQUIRE(tree(states, 4, 9) == 18);
+		REQUIRE(opened == 4);
+
+	}
+
+	{
+
+		// Edges anywhere in the tree, decisions too
+
+		auto deep = Share(!(isHigh + open) | isEven - close);
+		static_assert(decltype(deep)::slots == 2);
+		auto many = deep.States(1000);
+
+		opened = 0;
+		for (size_t e{}; e < 1000; ++e)
+			(void)deep(many, e, 7);
+		REQUIRE(opened == 1000);
+
+		static_assert(decltype(Share(isHigh && work || work))::slots == 0);
+
+	}
+
+	{
+
+		// Edges under resumable and reactive nodes have a slot too
+
+		Action step{ [](int) { return Status::Success; } };
+		auto resumed = Resumable((isHigh + open) & step | step);
+		static_assert(impl::SlotCount<decltype(resumed)>() == 1);
+		static_assert(impl::SlotCount<impl::Cached<decltype(isHigh + open)>>() == 1);
+
+		// Only edges keep their state per instance, a tree with other state can not be shared
+
+		int calls{};
+		Action counted{ [calls](int i) mutable { return i + ++calls; } };
+
+		static_assert( impl::InstanceSafe<decltype(isHigh +open -close & work), int>());
+		static_assert(!impl::InstanceSafe<decltype(resumed), int>());
+		static_assert(!impl::InstanceSafe<decltype(isHigh && counted || work), int>());
+		static_assert(!impl::InstanceSafe<decltype(Memo(isHigh) && work || work), int>());
+		static_assert(!impl::InstanceSafe<decltype(Adaptive(isHigh & isHigh) + open & work), int>());
+		static_assert(!impl::InstanceSafe<decltype(isHigh && Firewall<int(int)>(work) || work), int>());
+		static_assert(!impl::InstanceSafe<impl::Cached<decltype(isHigh + open)>, int>());
+
+	}
+
+}
+
+TEST_CASE("Test firewall")
+{
+
+	// Normally built in a translation unit of its own
+	auto subtree = isNotZero && Action{ [](int i) { return i * 2; } } || Action{ [](int) { return -1; } };
+	auto outside = Firewall<int(int)>(subtree);
+
+	static_assert(std::is_same_v<decltype(outside), ActionFirewall<int(int)>>);
+#ifndef JL_ACTION_TREE_PROFILE
+	static_assert(sizeof(outside) == 2 * sizeof(void*));
+#endif
+
+	REQUIRE(outside(3) ==  6);
+	REQUIRE(outside(0) == -1);
+
+	{
+
+		// Part of a larger tree, the type of the tree does not depend on the subtree
+
+		Action add{ [](int i) { return i + 1; } };
+		auto tree = isEven && outside || add;
+		REQUIRE(tree(4) == 8);
+		REQUIRE(tree(3) == 4);
+
+	}
+
+	{
+
+		// Decisions, references and void
+
+		Decision big{ [](int const& i) { return i > 10; } };
+		auto isBig = Firewall<bool(int const&)>(big);
+		static_assert(std::is_same_v<decltype(isBig), DecisionFirewall<bool(int const&)>>);
+		REQUIRE(( isBig(11)));
+		REQUIRE((!isBig(10)));
+		REQUIRE((!isBig)(10));
+
+		Action bump{ [](int& i) { ++i; } };
+		auto bumped = Firewall<void(int&)>(bump);
+		int value{ 1 };
+		bumped(value);
+		REQUIRE(value == 2);
+
+	}
+
+	{
+
+		// State stays in the subtree, all firewalls to it share it
+
+		Action count{ [n = 0](int) mutable { return ++n; } };
+		auto a = Firewall<int(int)>(count);
+		auto b = a;
+		REQUIRE(a(0) == 1);
+		REQUIRE(b(0) == 2);
+		REQUIRE(count(0) == 3);
+
+	}
+
+	ActionFirewall<int(int)> empty{};
+	REQUIRE(!empty);
+	REQUIRE_THROWS_AS(empty(0), std::bad_function_call);
+
+}
+
+TEST_CASE("Test profiling")
+{
+
+#ifdef JL_ACTION_TREE_PROFILE
+
+	ProfileReset();
+
+	Decision isEven = Label(Decision{ [](int i) { return i % 2 == 0; } }, "isEven");
+	Decision isSmall{ [](int i) { return i < 10; } };
+	Action   twice  { [](int i) { return i * 2; } };
+	Action   count  { [](int) {} };
+
+	auto tree = Label(isEven && twice || Action{ [](int) { return -1; } }, "tree");
+	auto cond = Label(isEven & twice, "cond");
+	auto edge = Label(isSmall - count, "edge");
+
+	for (int i{}; i < 20; ++i)
+	{
+		(void)tree(i);
+		(void)cond(i);
+		(void)edge(i);
+	}
+
+	auto const entries = ProfileSnapshot();
+	auto find = [&](std::string const& label) { return *std::find_if(entries.begin(), entries.end(), [&](auto const& e) { return e.label == label; }); };
+
+	auto const root = find("tree");
+	REQUIRE(root.kind   == "stack");
+	REQUIRE(root.parent == 0);
+	REQUIRE(root.calls  == 20);
+	REQUIRE(!root.taken);
+	REQUIRE(root.exclusive <= root.inclusive);
+
+	// Copies share their counters, the first caller is the parent
+	auto const even = find("isEven");
+	REQUIRE(even.kind   == "decision");
+	REQUIRE(even.parent == root.id);
+	REQUIRE(even.calls  == 40);
+	REQUIRE(even.taken  == 20u);
+
+	REQUIRE(find("cond").kind  == "conditional");
+	REQUIRE(find("cond").taken == 10u);
+
+	// Falls once, at 10
+	REQUIRE(find("edge").kind  == "falling edge");
+	REQUIRE(find("edge").calls == 20);
+	REQUIRE(find("edge").taken == 1u);
+
+	std::ostringstream report{};
+	ProfileReport(report);
+	REQUIRE(report.str().find("tree (stack)")        != std::string::npos);
+	REQUIRE(report.str().find("  isEven (decision)") != std::string::npos);
+
+	uint64_t calls{};
+	for (auto const& e : entries)
+		calls += e.calls;
+
+	std::ostringstream trace{};
+	ProfileTrace(trace);
+	std::string const json{ trace.str() };
+	uint64_t events{};
+	for (size_t at{ json.find("\"ph\":\"X\"") }; at != std::string::npos; at = json.find("\"ph\":\"X\"", at + 1))
+		++events;
+	REQUIRE(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+	REQUIRE(events == calls);
+
+	ProfileReset();
+	REQUIRE(ProfileSnapshot().empty());
+
+#else
+
+	// Not profiling: nodes are exactly what they wrap
+
+	auto counter = [i = 0](int) mutable { return ++i; };
+	auto labeled = Label(Action{ counter }, "counter");
+	REQUIRE(sizeof(labeled) == sizeof(counter));
+	REQUIRE(labeled(0) == 1);
+	REQUIRE(ProfileSnapshot().empty());
+
+#endif
+
+}
+
+TEST_CASE("Test dynamic action")
+{
+
+	Action half{ [](int i) { return float(i) / 2.f; } };
+	Action sqr { [](int i) { return float(i) * float(i); } };
+
+
+	ActionDynamic<float(int)> act{ half };
+	REQUIRE_TYPE(float, act(0));
+
+	REQUIRE(act(3) == 1.5f);
+	
+	act = sqr;
+	REQUIRE(act(3) == 9.0f);
+
+}
+
+TEST_CASE("Test dynamic action inplace")
+{
+
+	Action half{ [](int i) { return float(i) / 2.f; } };
+	Action sqr { [](int i) { return float(i) * float(i); } };
+
+	{
+
+		// Copyable
+
+		ActionDynamicInplace<float(int), 16> act{ half };
+		REQUIRE_TYPE(float, act(0));
+
+		REQUIRE(act(3) == 1.5f);
+
+		auto copy = act;
+		act = sqr;
+		REQUIRE(act (3) == 9.0f);
+		REQUIRE(copy(3) == 1.5f);
+
+		ActionDynamicInplace<float(int)> empty{};
+		REQUIRE(!empty);
+		REQUIRE_THROWS_AS(empty(3), std::bad_function_call);
+
+	}
+
+	{
+
+		// Move only
+
+		Action owned{ [p = std::make_unique<int>(4)](int i) { return *p * i; } };
+
+		ActionDynamicMoveOnly<int(int)> act{ isNotZero && std::move(owned) || Action{ [](int) { return -1; } } };
+		REQUIRE(act(2) ==  8);
+		REQUIRE(act(0) == -1);
+
+		auto moved = std::move(act);
+		REQUIRE(!act);
+		REQUIRE(moved(2) == 8);
+
+		static_assert(!std::is_copy_constructible_v<ActionDynamicMoveOnly<int(int)>>);
+
+	}
+
+	{
+
+		// Destroys what it holds
+
+		auto shared = std::make_shared<int>(0);
+
+		ActionDynamicInplace<int(int)> act{ Action{ [shared](int i) { return i; } } };
+		REQUIRE(shared.use_count() == 2);
+
+		act = Action{ [](int i) { return i; } };
+		REQUIRE(shared.use_count() == 1);
+
+	}
+
+}
+
+TEST_CASE("Test copy free composition")
+{
+
+	auto check   = [] { return Decision{ [c = Counted{}](auto&&) { return true; } }; };
+	auto counted = [] { return Action  { [c = Counted{}](auto&&) { return 1;    } }; };
+
+	{
+
+		// Ten levels deep, each wrapping the previous subtree
+
+		Counted::reset();
+
+		auto tree{
+			!(check() & check() | check()) +counted() -counted()
+			& (counted() | counted())
+			| counted() | counted()
+			| JL::Visitor{ [](auto&&) { return 0; } }
+		};
+
+		REQUIRE(Counted::copies == 0);
+		REQUIRE(Counted::moves  != 0);
+
+		tree(0);
+		REQUIRE(Counted::copies == 0);
+
+	}
+
+	{
+
+		// Branch stacks
+
+		Counted::reset();
+
+		auto stack = check() && counted() || check() && counted() || check() && counted() || counted();
+
+		REQUIRE(Counted::copies == 0);
+		REQUIRE(stack(0) == 1);
+		REQUIRE(Counted::copies == 0);
+
+	}
+
+	{
+
+		// Move-only captures
+
+		Action owned{ [p = std::make_unique<int>(4)](int i) { return *p * i; } };
+
+		auto tree = isNotZero && std::move(owned) || Action{ [](int) { return -1; } };
+
+		REQUIRE(tree(2) == 8);
+		REQUIRE(tree(0) == -1);
+
+	}
+
+	{
+
+		// Arguments are forwarded into the last call
+
+		struct Message : Counted {};
+
+		Counted::reset();
+
+		auto sequence = Action{ [](Message const&) {} } | Action{ [](Message m) { return m; } };
+		auto branch   = Decision{ [](Message const&) { return true; } } && Action{ [](Message m) { return m; } } || Action{ [](Message m) { return m; } };
+
+		sequence(Message{});
+		branch  (Message{});
+		REQUIRE(Counted::copies == 0);
+
+	}
+
+}
@@ -0,0 +1,248 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		// A unit of work that lives on the stack of whoever waits for it
+		struct PoolTask
+		{
+			void (*run)(PoolTask&){};
+			void*  context{};
+
+			std::atomic<bool>  done{};
+			std::exception_ptr error{};
+			size_t             queue{};
+		};
+
+	}
+
+	// Work-stealing thread pool. Every worker owns a queue, takes its newest task first
+	// and steals the oldest task of another worker when its own queue is empty.
+	class ThreadPool
+	{
+	public:
+
+		explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(ThreadPool const&) = delete;
+		ThreadPool& operator = (ThreadPool const&) = delete;
+
+		static ThreadPool& Default();
+
+		size_t Size() const noexcept;
+
+		// Queues a task, returns false when the pool is saturated and the task should be run inline instead.
+		bool Submit(impl::PoolTask&);
+
+		// Waits until the task is done. A task that has not been started yet is taken back and run by the caller,
+		// otherwise the caller helps out with other tasks in the mean time.
+		void Wait(impl::PoolTask&);
+
+	private:
+
+		struct Queue
+		{
+			std::mutex                  lock;
+			std::deque<impl::PoolTask*> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread>            workers;
+
+		std::atomic<size_t>     pending{};
+		std::atomic<size_t>     next{};
+		std::atomic<bool>       stop{};
+		std::mutex              sleepLock;
+		std::condition_variable sleep;
+
+		static inline thread_local ThreadPool* currentPool{};
+		static inline thread_local size_t      currentQueue{};
+
+		void             Work   (size_t);
+		impl::PoolTask*  Take   (size_t);
+		bool             Retract(impl::PoolTask&);
+		static void      Run    (impl::PoolTask&);
+	};
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	inline ThreadPool::ThreadPool(size_t threads)
+	{
+		threads = threads ? threads : 1;
+		for (size_t i{}; i < threads; ++i)
+			queues.push_back(std::make_unique<Queue>());
+		for (size_t i{}; i < threads; ++i)
+			workers.emplace_back([this, i] { Work(i); });
+	}
+
+	inline ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard guard{ sleepLock };
+			stop = true;
+		}
+		sleep.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	inline ThreadPool& ThreadPool::Default()
+	{
+		static ThreadPool pool{};
+		return pool;
+	}
+
+	inline size_t ThreadPool::Size() const noexcept
+	{
+		return workers.size();
+	}
+
+	inline bool ThreadPool::Submit(impl::PoolTask& task)
+	{
+		// Every worker already has a backlog, queueing more only adds latency
+		if (pending.load(std::memory_order_relaxed) >= 2 * workers.size())
+			return false;
+
+		task.queue = currentPool == this
+			? currentQueue
+			: next.fetch_add(1, std::memory_order_relaxed) % queues.size();
+		{
+			auto& queue = *queues[task.queue];
+			std::lock_guard guard{ queue.lock };
+			queue.tasks.push_back(&task);
+		}
+		pending.fetch_add(1, std::memory_order_release);
+		{
+			std::lock_guard guard{ sleepLock };
+		}
+		sleep.notify_one();
+		return true;
+	}
+
+	inline void ThreadPool::Wait(impl::PoolTask& task)
+	{
+		if (Retract(task))
+			Run(task);
+
+		size_t const home = currentPool == this ? currentQueue : task.queue;
+		for (unsigned spin{}; !task.done.load(std::memory_order_acquire); ++spin)
+		{
+			if (auto* other = Take(home))
+				Run(*other);
+			else
+			if (spin > 64)
+				std::this_thread::yield();
+		}
+
+		if (task.error)
+			std::rethrow_exception(task.error);
+	}
+
+	inline void ThreadPool::Work(size_t index)
+	{
+		currentPool  = this;
+		currentQueue = index;
+
+		while (true)
+		{
+			if (auto* task = Take(index))
+			{
+				Run(*task);
+				continue;
+			}
+
+			std::unique_lock guard{ sleepLock };
+			sleep.wait(guard, [this] { return stop || pending.load(std::memory_order_acquire) != 0; });
+			if (stop)
+				return;
+		}
+	}
+
+	inline impl::PoolTask* ThreadPool::Take(size_t index)
+	{
+		// Own queue, newest first
+		{
+			auto& queue = *queues[index];
+			std::lock_guard guard{ queue.lock };
+			if (!queue.tasks.empty())
+			{
+				auto* task = queue.tasks.back();
+				queue.tasks.pop_back();
+				pending.fetch_sub(1, std::memory_order_relaxed);
+				return task;
+			}
+		}
+
+		// Steal from the others, oldest first
+		for (size_t i{ 1 }; i < queues.size(); ++i)
+		{
+			auto& queue = *queues[(index + i) % queues.size()];
+			std::lock_guard guard{ queue.lock };
+			if (!queue.tasks.empty())
+			{
+				auto* task = queue.tasks.front();
+				queue.tasks.pop_front();
+				pending.fetch_sub(1, std::memory_order_relaxed);
+				return task;
+			}
+		}
+
+		return nullptr;
+	}
+
+	inline bool ThreadPool::Retract(impl::PoolTask& task)
+	{
+		auto& queue = *queues[task.queue];
+		std::lock_guard guard{ queue.lock };
+		for (auto it = queue.tasks.rbegin(); it != queue.tasks.rend(); ++it)
+			if (*it == &task)
+			{
+				queue.tasks.erase(std::next(it).base());
+				pending.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		return false;
+	}
+
+	inline void ThreadPool::Run(impl::PoolTask& task)
+	{
+		try
+		{
+			task.run(task);
+		}
+		catch (...)
+		{
+			task.error = std::current_exception();
+		}
+		task.done.store(true, std::memory_order_release);
+	}
+
+}
@@ -0,0 +1,353 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Shared.h"
+
+#include <cstdint>
+
+namespace JL::action_tree
+{
+
+	// Outcome of an action that may take more than one tick
+	enum class Status : uint8_t
+	{
+		Success,
+		Failure,
+		Running,
+	};
+
+	// Same tree, run one tick per call. Where all children return a Status:
+	//   a | b | c            runs the actions in order, until one fails or is running
+	//   d & a                Failure when the decision does not hold
+	//   d && a || b          the action of the first branch whose decision holds
+	// The next call continues at the action that was running, the nodes before it and the decisions above it do not run again.
+	// Nodes with other results run as they always do.
+	template <typename T>
+	auto /* Action */ Resumable(Action<T>);
+
+	// Forgets the actions that were running, the next call starts from the top
+	template <typename T>
+	void Halt(Action<T>&);
+
+	namespace impl
+	{
+
+		// a | b | ..., resumed at `cursor`
+		template <typename S>
+		struct ResumeSequence
+		{
+			S      sequence;
+			size_t cursor{};
+
+			template <typename ... P>
+			auto operator () (P&& ...);
+
+			template <size_t I, typename ... P>
+			Status Run(P&& ...);
+		};
+
+		// d1 && a1 || ..., resumed at the branch that is `active`
+		template <typename C>
+		struct ResumeCascade
+		{
+			static constexpr size_t idle = ~size_t{};
+
+			C      cascade;
+			size_t active = idle;
+
+			template <typename ... P>
+			auto operator () (P&& ...);
+
+			template <size_t I, typename ... P>
+			Status Run(P&& ...);
+		};
+
+		// d & a, the decision is not asked again while the action is running
+		template <typename C>
+		struct ResumeConditional
+		{
+			C    conditional;
+			bool running{};
+
+			template <typename ... P>
+			auto operator () (P&& ...);
+		};
+
+		template <typename Actions, typename ... P>
+		struct AllStatus;
+
+		template <typename ... A, typename ... P>
+		struct AllStatus<std::tuple<A...>, P...> : std::bool_constant<(std::is_same_v<std::invoke_result_t<A&, P&...>, Status> && ...)> {};
+
+		// The tree with resumable nodes in place of the nodes that can be, other nodes are kept as they are
+		template <typename N>
+		N Resume(N);
+
+		template <typename F>
+		auto Resume(Action<F>);
+		template <typename F>
+		auto Resume(Decision<F>);
+		template <typename ... A>
+		auto Resume(Sequence<A...>);
+		template <typename A, typename ... B>
+		auto Resume(Cascade<A, B...>);
+		template <typename D, typename A>
+		auto Resume(Conditional<D, A>);
+
+		template <typename S>
+		auto NodeChildren(ResumeSequence<S>&);
+		template <typename C>
+		auto NodeChildren(ResumeCascade<C>&);
+		template <typename C>
+		auto NodeChildren(ResumeConditional<C>&);
+
+		// Where they resume is not kept per instance of a shared tree
+		template <typename S, typename ... P>
+		struct KeepsState<ResumeSequence<S>, P...> : std::true_type {};
+		template <typename C, typename ... P>
+		struct KeepsState<ResumeCascade<C>, P...> : std::true_type {};
+		template <typename C, typename ... P>
+		struct KeepsState<ResumeConditional<C>, P...> : std::true_type {};
+
+		template <typename N>
+		void HaltNode(N&);
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree::impl
+{
+
+	//--------------------
+	//   ResumeSequence
+
+	template <typename S>
+	template <typename ... P>
+	auto ResumeSequence<S>::operator()(P&& ... p)
+	{
+		if constexpr (AllStatus<decltype(sequence.actions), P...>::value)
+			return Run<0>(std::forward<P>(p)...);
+		else
+			return sequence(std::forward<P>(p)...);
+	}
+
+	template <typename S>
+	template <size_t I, typename ... P>
+	Status ResumeSequence<S>::Run(P&& ... p)
+	{
+		constexpr size_t N = std::tuple_size_v<decltype(sequence.actions)>;
+		if constexpr (I == N)
+		{
+			cursor = 0;
+			return Status::Success;
+		}
+		else
+		{
+			if (cursor <= I)
+			{
+				Status status;
+				if constexpr (I + 1 == N)
+					status = std::get<I>(sequence.actions)(std::forward<P>(p)...);
+				else
+					status = std::get<I>(sequence.actions)(p...);
+
+				if (status != Status::Success)
+				{
+					cursor = status == Status::Running ? I : 0;
+					return status;
+				}
+			}
+			return Run<I + 1>(std::forward<P>(p)...);
+		}
+	}
+
+	//-------------------
+	//   ResumeCascade
+
+	template <typename C>
+	template <typename ... P>
+	auto ResumeCascade<C>::operator()(P&& ... p)
+	{
+		if constexpr (std::is_same_v<decltype(cascade(p...)), Status>)
+			return Run<0>(std::forward<P>(p)...);
+		else
+			return cascade(std::forward<P>(p)...);
+	}
+
+	template <typename C>
+	template <size_t I, typename ... P>
+	Status ResumeCascade<C>::Run(P&& ... p)
+	{
+		auto track = [this](size_t branch, Status status)
+		{
+			active = status == Status::Running ? branch : idle;
+			return status;
+		};
+
+		constexpr size_t N = std::tuple_size_v<decltype(cascade.branches)>;
+		if constexpr (I == N)
+			return track(I, cascade.fallback(std::forward<P>(p)...));
+		else
+		{
+			auto& branch = std::get<I>(cascade.branches);
+			if (active == I || (active == idle && branch.decision(p...)))
+				return track(I, branch.action(std::forward<P>(p)...));
+			return Run<I + 1>(std::forward<P>(p)...);
+		}
+	}
+
+	//-----------------------
+	//   ResumeConditional
+
+	template <typename C>
+	template <typename ... P>
+	auto ResumeConditional<C>::operator()(P&& ... p)
+	{
+		if constexpr (std::is_same_v<decltype(conditional.action(p...)), Status>)
+		{
+			if (!running && !conditional.decision(p...))
+				return Status::Failure;
+			Status const status = conditional.action(std::forward<P>(p)...);
+			running = status == Status::Running;
+			return status;
+		}
+		else
+			return conditional(std::forward<P>(p)...);
+	}
+
+	//------------
+	//   Resume
+
+	template <typename N>
+	N Resume(N node)
+	{
+		return node;
+	}
+
+	template <typename F>
+	auto Resume(Action<F> node)
+	{
+		auto resumed = Resume(static_cast<F&&>(node));
+		return Action<decltype(resumed)>{ std::move(resumed) };
+	}
+
+	template <typename F>
+	auto Resume(Decision<F> node)
+	{
+		auto resumed = Resume(static_cast<F&&>(node));
+		return Decision<decltype(resumed)>{ std::move(resumed) };
+	}
+
+	template <typename ... A>
+	auto Resume(Sequence<A...> node)
+	{
+		return std::apply(
+			[](auto&& ... actions)
+			{
+				using Sequence = Sequence<decltype(Resume(std::move(actions)))...>;
+				return ResumeSequence<Sequence>{ Sequence{ { Resume(std::move(actions))... } } };
+			},
+			std::move(node.actions)
+		);
+	}
+
+	template <typename A, typename ... B>
+	auto Resume(Cascade<A, B...> node)
+	{
+		return std::apply(
+			[&node](auto&& ... branches)
+			{
+				using Cascade = Cascade<
+					decltype(Resume(std::move(node.fallback))),
+					Branch<decltype(Resume(std::move(branches.decision))), decltype(Resume(std::move(branches.action)))>...
+				>;
+				return ResumeCascade<Cascade>{ Cascade{
+					{ { Resume(std::move(branches.decision)), Resume(std::move(branches.action)) }... },
+					Resume(std::move(node.fallback))
+				} };
+			},
+			std::move(node.branches)
+		);
+	}
+
+	template <typename D, typename A>
+	auto Resume(Conditional<D, A> node)
+	{
+		using Conditional = Conditional<decltype(Resume(std::move(node.decision))), decltype(Resume(std::move(node.action)))>;
+		return ResumeConditional<Conditional>{ Conditional{ Resume(std::move(node.decision)), Resume(std::move(node.action)) } };
+	}
+
+	//----------
+	//   Halt
+
+	template <typename S>
+	auto NodeChildren(ResumeSequence<S>& node)
+	{
+		return NodeChildren(node.sequence);
+	}
+
+	template <typename C>
+	auto NodeChildren(ResumeCascade<C>& node)
+	{
+		return NodeChildren(node.cascade);
+	}
+
+	template <typename C>
+	auto NodeChildren(ResumeConditional<C>& node)
+	{
+		return NodeChildren(node.conditional);
+	}
+
+	template <typename N>
+	void Stop(N&) {}
+
+	template <typename S>
+	void Stop(ResumeSequence<S>& node) { node.cursor = 0; }
+
+	template <typename C>
+	void Stop(ResumeCascade<C>& node) { node.active = node.idle; }
+
+	template <typename C>
+	void Stop(ResumeConditional<C>& node) { node.running = false; }
+
+	template <typename N>
+	void HaltNode(N& node)
+	{
+		Stop(node);
+		std::apply([](auto& ... child) { (HaltNode(child), ...); }, NodeChildren(node));
+	}
+
+}
+
+namespace JL::action_tree
+{
+
+	template <typename T>
+	auto Resumable(Action<T> action)
+	{
+		return impl::Resume(std::move(action));
+	}
+
+	template <typename T>
+	void Halt(Action<T>& action)
+	{
+		impl::HaltNode(action);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+// Copyright (C) 2021 Kobe Vrijsen <kobevrijsen@posteo.be>
+// 
+// ActionTree - Tree based decision/action stucture helper. An alternative to branches.
+// 
+// This file is free software and distributed under the terms of the European Union
+// Public Lincense as published by the European Commision; either version 1.2 of the
+// License, or, at your option, any later version.
+
+#pragma once
+
+#include "JL_ActionTree_Base.h"
+#include "JL_ActionTree_Action.h"
+#include "JL_ActionTree_Decision.h"
+#include "JL_ActionTree_Branch.h"
+#include "JL_ActionTree_Shared.h"
+
+#include <array>
+#include <cstdint>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+namespace JL::action_tree
+{
+
+	// Same stack, with every decision called on every run:
+	//
+	//   TruthTable(isHurt && flee || canSee && attack || isTired && rest || wander)
+	//
+	// The results of the decisions make a mask, one bit per branch. A table of every mask gives the first branch
+	// whose decision holds, and its action runs after a chain of compares on that index. The decisions no longer
+	// branch one by one, but picking the action still does: it only pays off when the decisions are cheap and
+	// their branches are hard to predict, and costs when the first decisions nearly always hold.
+	// The decisions can not keep state and can not be async, at most 64.
+	template <typename A, typename ... B>
+	constexpr auto /* Action */ TruthTable(Action<impl::Cascade<A, B...>>);
+
+	namespace impl
+	{
+
+		// Stacks of up to this many branches look up the first branch in a table of 2^k entries, larger stacks find it with a bit scan
+		constexpr size_t truthTableBits = 8;
+
+		template <typename C>
+		struct TruthTableStack
+		{
+			C cascade;
+
+			template <typename ... P>
+			constexpr auto operator () (P&& ...);
+			template <typename ... P>
+			constexpr auto operator () (P&& ...) const;
+		};
+
+		template <typename C, typename ... P>
+		struct Stateless<TruthTableStack<C>, P...> : Stateless<C, P...> {};
+
+		// Bit I is set when the decision of branch I holds
+		template <typename M, size_t ... I, typename B, typename ... P>
+		constexpr M TruthMask(std::index_sequence<I...>, B& branches, P& ...);
+
+		// Index of the first branch whose decision holds, the number of branches for none
+		template <size_t K, typename M>
+		constexpr size_t FirstTrue(M mask);
+
+		template <typename R, size_t I, typename C, typename ... P>
+		constexpr R RunTruthRow(C& cascade, P&& ...);
+
+		// The row of branch `row`, the fallback for the number of branches
+		template <typename R, size_t I, typename C, typename ... P>
+		constexpr R RunTruthRowAt(size_t row, C& cascade, P&& ...);
+
+		template <typename R, typename C, typename ... P>
+		constexpr R RunTruthTable(C& cascade, P&& ...);
+
+		template <typename C>
+		auto NodeChildren(TruthTableStack<C>&);
+
+	}
+
+}
+
+
+
+// Implementation
+
+namespace JL::action_tree
+{
+
+	namespace impl
+	{
+
+		template <typename M, size_t ... I, typename B, typename ... P>
+		constexpr M TruthMask(std::index_sequence<I...>, B& branches, P& ... p)
+		{
+			return (M{} | ... | (M(bool(std::get<I>(branches).decision(p...))) << I));
+		}
+
+		template <size_t K>
+		constexpr auto FirstTrueTable()
+		{
+			std::array<uint8_t, size_t{ 1 } << K> table{};
+			for (size_t mask{}; mask < table.size(); ++mask)
+			{
+				size_t first{};
+				while (first < K && !(mask >> first & 1))
+					++first;
+				table[mask] = uint8_t(first);
+			}
+			return table;
+		}
+
+		template <size_t K>
+		constexpr auto firstTrue = FirstTrueTable<K>();
+
+		template <size_t K, typename M>
+		constexpr size_t FirstTrue(M mask)
+		{
+			if constexpr (K <= truthTableBits)
+				return firstTrue<K>[mask];
+			else
+			{
+#ifdef __cpp_lib_bitops
+				return mask ? size_t(std::countr_zero(mask)) : K;
+#else
+				size_t first{};
+				while (first < K && !(mask >> first & 1))
+					++first;
+				return first;
+#endif
+			}
+		}
+
+		template <typename R, size_t I, typename C, typename ... P>
+		constexpr R RunTruthRow(C& cascade, P&& ... p)
+		{
+			if constexpr (I == std::tuple_size_v<decltype(cascade.branches)>)
+				return RunInto<R>(cascade.fallback, std::forward<P>(p)...);
+			else
+				return RunInto<R>(std::get<I>(cascade.branches).action, std::forward<P>(p)...);
+		}
+
+		template <typename R, size_t I, typename C, typename ... P>
+		constexpr R RunTruthRowAt(size_t row, C& cascade, P&& ... p)
+		{
+			if constexpr (I == std::tuple_size_v<decltype(cascade.branches)>)
+				return RunTruthRow<R, I>(cascade, std::forward<P>(p)...);
+			else
+			if (row == I)
+				return RunTruthRow<R, I>(cascade, std::forward<P>(p)...);
+			else
+				return RunTruthRowAt<R, I + 1>(row, cascade, std::forward<P>(p)...);
+		}
+
+		template <typename C, typename ... P>
+		struct PureDecisions;
+
+		template <typename A, typename ... B, typename ... P>
+		struct PureDecisions<Cascade<A, B...>, P...> : std::conjunction<Stateless<decltype(std::declval<B&>().decision), P...>...> {};
+
+		template <typename R, typename C, typename ... P>
+		constexpr R RunTruthTable(C& cascade, P&& ... p)
+		{
+			constexpr size_t K = std::tuple_size_v<decltype(cascade.branches)>;
+			using Mask = std::conditional_t<(K <= 32), uint32_t, uint64_t>;
+			static_assert(K <= 64, "TruthTable  A stack can have at most 64 branches.");
+
+			Mask const mask = TruthMask<Mask>(std::make_index_sequence<K>{}, cascade.branches, p...);
+			return RunTruthRowAt<R, 0>(FirstTrue<K>(mask), cascade, std::forward<P>(p)...);
+		}
+
+		template <typename C>
+		template <typename ... P>
+		constexpr auto TruthTableStack<C>::operator()(P&& ... p)
+		{
+			static_assert(PureDecisions<C, P...>::value, "TruthTable  Every decision is called on every run, decisions can not keep state.");
+			static_assert(!is_awaitable_v<decltype(cascade(p...))>, "TruthTable  Stacks with async nodes can not be tabled.");
+
+			using R = decltype(cascade(p...));
+			return RunTruthTable<R>(cascade, std::forward<P>(p)...);
+		}
+
+		template <typename C>
+		template <typename ... P>
+		constexpr auto TruthTableStack<C>::operator()(P&& ... p) const
+		{
+			RequireStateless<P...>(*this);
+			using R = decltype(cascade(p...));
+			return RunTruthTable<R>(cascade, std::forward<P>(p)...);
+		}
+
+		template <typename C>
+		auto NodeChildren(TruthTableStack<C>& node)
+		{
+			return NodeChildren(node.cascade);
+		}
+
+	}
+
+	template <typename A, typename ... B>
+	constexpr auto TruthTable(Action<impl::Cascade<A, B...>> stack)
+	{
+		using Table = impl::TruthTableStack<impl::Cascade<A, B...>>;
+		return Action<Table>{ Table{ static_cast<impl::Cascade<A, B...>&&>(stack) } };
+	}
+
+}
\ No newline at end of file
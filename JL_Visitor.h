@@ -10,10 +10,28 @@
 
 #include <variant>
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 namespace JL
 {
 
+	// Types like std::expected<T, E>: a value, or the error that kept it from being made
+	template <typename T, typename = void>
+	struct is_expected : std::false_type {};
+
+	template <typename T>
+	struct is_expected<T, std::void_t<
+		typename T::value_type,
+		typename T::error_type,
+		typename T::unexpected_type,
+		decltype(std::declval<T const&>().has_value()),
+		decltype(std::declval<T const&>().error())
+	>> : std::true_type {};
+
+	template <typename T>
+	constexpr bool is_expected_v = is_expected<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
 	template<typename ...Base>
 	struct Visitor : Base...
 	{
@@ -32,6 +50,12 @@ namespace JL
 		constexpr auto operator() (std::optional<T> const& optional) const;
 		template <typename T>
 		constexpr auto operator() (std::optional<T> const& optional);
+
+		// Unless one of the lambdas takes the expected itself
+		template <typename X, typename = std::enable_if_t<is_expected_v<X> && !(std::is_invocable_v<Base const&, X const&> || ...)>>
+		constexpr auto operator() (X const& expected) const;
+		template <typename X, typename = std::enable_if_t<is_expected_v<X> && !(std::is_invocable_v<Base&, X const&> || ...)>>
+		constexpr auto operator() (X const& expected);
 	};
 
 	template<typename ...T>
@@ -122,4 +146,40 @@ namespace JL
 		}
 	}
 
+	template<typename ...B>
+	template<typename X, typename>
+	constexpr auto Visitor<B...>
+	::operator() (X const& expected) const
+	{
+		if (expected.has_value())
+		{
+			if constexpr (std::is_void_v<typename X::value_type>)
+				return operator()();
+			else
+				return operator()(*expected);
+		}
+		else
+		{
+			return operator()(expected.error());
+		}
+	}
+
+	template<typename ...B>
+	template<typename X, typename>
+	constexpr auto Visitor<B...>
+	::operator() (X const& expected)
+	{
+		if (expected.has_value())
+		{
+			if constexpr (std::is_void_v<typename X::value_type>)
+				return operator()();
+			else
+				return operator()(*expected);
+		}
+		else
+		{
+			return operator()(expected.error());
+		}
+	}
+
 }
\ No newline at end of file